@@ -4,8 +4,97 @@
 
 #include "src/Eva.h"
 
+#include <cstring>
+#include <iostream>
 #include <string>
 
+/*
+ * What to do with the program.
+ */
+enum class Action {
+  // Compile it, writing the selected output.
+  Exec,
+
+  // Run it with the JIT, exiting with its exit code.
+  Run,
+};
+
+/*
+ * Command-line options:
+ *
+ *   -O0 -O1 -O2 -O3 -Os -Oquick   Optimization level (default: -O0)
+ *   -march=native                  Generate code for the host CPU
+ *                                  (default: a portable baseline)
+ *   --ast-cache <dir>              Cache parsed ASTs in <dir>
+ *   --stream                       Compile top-level forms as they are parsed
+ *   --merge-strings                Merge string constants into the ones
+ *                                  they are suffixes of
+ *   --run                          Run the program with the JIT
+ *   --emit=none|ll|bc|obj|exe      Output: nothing, textual IR, bitcode,
+ *                                  a native object file or executable
+ *                                  (default: ll)
+ *   -o <file>                      Output file (default: ./out.ll, ./out.bc,
+ *                                  ./out.o, ./out)
+ *   --print-ir                     Print the generated IR to stdout
+ */
+static bool parseOptions(int argc, char const *argv[], EvaOptions& options,
+                         Action& action, EmitOptions& emit) {
+  static const std::pair<const char*, OptLevel> optLevels[] = {
+    {"-O0", OptLevel::O0}, {"-O1", OptLevel::O1}, {"-O2", OptLevel::O2},
+    {"-O3", OptLevel::O3}, {"-Os", OptLevel::Os}, {"-Oquick", OptLevel::Quick},
+  };
+
+  static const std::pair<const char*, EmitMode> emitModes[] = {
+    {"--emit=none", EmitMode::None}, {"--emit=ll", EmitMode::IR}, {"--emit=bc", EmitMode::Bitcode},
+    {"--emit=obj", EmitMode::Object}, {"--emit=exe", EmitMode::Executable},
+  };
+
+  for (auto i = 1; i < argc; i++) {
+    auto arg = argv[i];
+    auto known = false;
+
+    for (auto& [flag, level] : optLevels) {
+      if (std::strcmp(arg, flag) == 0) {
+        options.optLevel = level;
+        known = true;
+      }
+    }
+
+    for (auto& [flag, mode] : emitModes) {
+      if (std::strcmp(arg, flag) == 0) {
+        emit.mode = mode;
+        known = true;
+      }
+    }
+
+    if (known) {
+      continue;
+    } else if (std::strcmp(arg, "-march=native") == 0) {
+      options.nativeCpu = true;
+    } else if (std::strcmp(arg, "--ast-cache") == 0 && i + 1 < argc) {
+      options.astCacheDir = argv[++i];
+    } else if (std::strcmp(arg, "--stream") == 0) {
+      options.streaming = true;
+    } else if (std::strcmp(arg, "--merge-strings") == 0) {
+      options.mergeStrings = true;
+    } else if (std::strcmp(arg, "--run") == 0) {
+      action = Action::Run;
+    } else if (std::strcmp(arg, "-o") == 0 && i + 1 < argc) {
+      emit.path = argv[++i];
+    } else if (std::strcmp(arg, "--print-ir") == 0) {
+      emit.printIR = true;
+    } else {
+      std::cerr << "Unknown option: " << arg << "\n"
+                << "Usage: eva [-O0|-O1|-O2|-O3|-Os|-Oquick] [-march=native] [--ast-cache <dir>] [--stream]\n"
+                << "           [--merge-strings]\n"
+                << "           [--run | [--emit=none|ll|bc|obj|exe] [-o <file>] [--print-ir]]\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int main(int argc, char const *argv[]) {
   /*
    * Program to execute.
@@ -23,15 +112,33 @@ int main(int argc, char const *argv[]) {
     (printf "X: %d\n\n" x)
   )";
 
+  /*
+   * Compiler options.
+   */
+  EvaOptions options;
+  auto action = Action::Exec;
+  EmitOptions emit;
+
+  if (!parseOptions(argc, argv, options, action, emit)) {
+    return 1;
+  }
+
   /*
    * Compiler instance.
    */
-  Eva vm;
+  Eva vm(options);
+
+  /*
+   * Run the program in-process.
+   */
+  if (action == Action::Run) {
+    return vm.run(program);
+  }
 
   /*
-   * Generate LLVM IR.
+   * Generate LLVM IR, bitcode or native code.
    */
-  vm.exec(program);
+  vm.exec(program, emit);
 
   return 0;
-}
\ No newline at end of file
+}
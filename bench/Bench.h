@@ -0,0 +1,50 @@
+/*
+ * Benchmark helpers.
+ */
+
+#ifndef EVA_BENCH_H
+#define EVA_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+/*
+ * Runs a function and returns the elapsed wall time in seconds.
+ */
+template <typename Fn>
+double timeIt(Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+/*
+ * Repeats an Eva snippet until the program reaches the given size in bytes.
+ */
+inline std::string generateProgram(const std::string& snippet, size_t size) {
+  std::string program;
+  program.reserve(size + snippet.size());
+
+  while (program.size() < size) {
+    program += snippet;
+  }
+
+  return program;
+}
+
+/*
+ * Formats a byte count: 1KB, 10MB, etc.
+ */
+inline std::string formatSize(size_t bytes) {
+  char buf[32];
+  if (bytes >= 1000 * 1024) {
+    std::snprintf(buf, sizeof(buf), "%.0fMB", bytes / (1024.0 * 1024));
+  } else {
+    std::snprintf(buf, sizeof(buf), "%.0fKB", bytes / 1024.0);
+  }
+  return buf;
+}
+
+#endif //EVA_BENCH_H
@@ -0,0 +1,102 @@
+/*
+ * Codegen benchmark.
+ *
+ * Generates LLVM IR for deeply nested blocks, each updating a variable of
+ * the outermost one, then for long sequences of small blocks, and reports
+ * the time and the heap allocations made by codegen (parsing excluded)
+ * per block.
+ *
+ * Usage: eva_codegen_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "../src/Eva.h"
+#include "Bench.h"
+
+/*
+ * Heap allocation counter.
+ */
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  if (auto p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+/*
+ * (begin (var x 0) (begin (set x x) (begin (set x x) ...)))
+ */
+static std::string nestedProgram(int depth) {
+  std::string program = "(var x 0)";
+
+  for (auto i = 0; i < depth; i++) {
+    program += " (begin (set x x)";
+  }
+  program.append(depth, ')');
+
+  return program;
+}
+
+/*
+ * (var x 0) (begin (var y x) (begin (set y x))) ...
+ */
+static std::string sequenceProgram(int blocks) {
+  std::string program = "(var x 0)";
+
+  for (auto i = 0; i < blocks; i += 2) {
+    program += " (begin (var y x) (begin (set y x)))";
+  }
+
+  return program;
+}
+
+/*
+ * Generates IR for programs of `blocks` blocks, and prints a table row
+ * for each.
+ */
+static void run(const char* label, std::string (*makeProgram)(int)) {
+  std::printf("%8s %12s %12s %14s %14s\n", label, "time (s)", "allocs", "allocs/block", "ns/block");
+
+  for (auto blocks : {10, 100, 1000, 5000}) {
+    auto program = makeProgram(blocks);
+
+    // Parsed up front, so only codegen is measured.
+    ProgramParser parser(1);
+    auto ast = parser.parse(program);
+
+    Eva eva;
+
+    size_t allocs = 0;
+    auto seconds = timeIt([&]() {
+      auto start = allocations;
+      eva.generate(ast.view());
+      allocs = allocations - start;
+    });
+
+    std::printf("%8d %12.4f %12zu %14.1f %14.1f\n", blocks, seconds, allocs,
+                (double) allocs / blocks, seconds * 1e9 / blocks);
+  }
+}
+
+int main(int argc, char const *argv[]) {
+  run("depth", nestedProgram);
+
+  std::printf("\n");
+  run("blocks", sequenceProgram);
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Whitespace and comment skipping microbenchmark.
+ *
+ * Tokenizes heavily indented and commented generated code, where most of
+ * the input is skipped rather than turned into tokens.
+ *
+ * Usage: eva_comment_bench [size in MB]
+ */
+
+#include <cstdlib>
+#include <cstdio>
+
+#include "../src/parser/EvaParser.h"
+#include "Bench.h"
+
+using syntax::Tokenizer;
+using syntax::TokenType;
+
+static const std::string snippet = R"(
+        /*
+         * Generated configuration entry.
+         *
+         * Do not edit: this block is regenerated on every build of the
+         * configuration tables.
+         */
+        (begin
+                // Entry identifier and its default value.
+                (var x 42)                        // default
+
+                                                  // overridden below
+                (set x 100)                       /* override */
+        )
+)";
+
+int main(int argc, char const *argv[]) {
+  size_t size = (argc > 1 ? std::atoi(argv[1]) : 100) * 1024 * 1024;
+
+#if defined(EVA_SIMD_AVX2)
+  std::printf("Skipping: AVX2\n\n");
+#elif defined(EVA_SIMD_SSE2)
+  std::printf("Skipping: SSE2\n\n");
+#else
+  std::printf("Skipping: scalar\n\n");
+#endif
+
+  auto program = generateProgram(snippet, size);
+
+  Tokenizer tokenizer;
+  size_t tokens = 0;
+
+  auto seconds = timeIt([&]() {
+    tokenizer.initString(program);
+    while (tokenizer.getNextToken().type != TokenType::__EOF) {
+      tokens++;
+    }
+  });
+
+  std::printf("%8s %12s %12s %10s\n", "size", "tokens", "time (s)", "MB/s");
+  std::printf("%8s %12zu %12.4f %10.1f\n", formatSize(size).c_str(), tokens,
+              seconds, program.size() / seconds / (1024 * 1024));
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Environment benchmark.
+ *
+ * Looks up variables in a global scope of 1k to 100k bindings through a
+ * chain of nested block scopes, then generates LLVM IR for programs with
+ * thousands of top-level variables, each read and updated.
+ *
+ * Usage: eva_environment_bench
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../src/Eva.h"
+#include "Bench.h"
+
+/*
+ * (var g0 0) ... (var gN N) (set g0 gK) ... (set gN gM)
+ */
+static std::string globalsProgram(int count) {
+  std::mt19937 random(42);
+  std::string program;
+
+  for (auto i = 0; i < count; i++) {
+    program += "(var g" + std::to_string(i) + " " + std::to_string(i) + ")\n";
+  }
+  for (auto i = 0; i < count; i++) {
+    program += "(set g" + std::to_string(i) + " g" + std::to_string(random() % count) + ")\n";
+  }
+
+  return program;
+}
+
+int main(int argc, char const *argv[]) {
+  constexpr auto DEPTH = 8;
+  constexpr auto LOOKUPS = 10'000'000;
+
+  std::printf("Lookups through %d nested scopes:\n\n", DEPTH);
+  std::printf("%10s %12s %12s\n", "globals", "time (s)", "ns/lookup");
+
+  for (auto count : {1000, 10'000, 100'000}) {
+    std::vector<Symbol> names;
+    EnvironmentStack environments;
+    auto env = environments.global();
+
+    for (auto i = 0; i < count; i++) {
+      names.push_back(intern("g" + std::to_string(i)));
+      env->define(names.back(), nullptr);
+    }
+
+    // Block scopes with a few locals each.
+    for (auto depth = 0; depth < DEPTH; depth++) {
+      env = environments.push(env);
+      for (auto i = 0; i < 4; i++) {
+        env->define(intern("l" + std::to_string(depth) + "_" + std::to_string(i)), nullptr);
+      }
+    }
+
+    std::mt19937 random(42);
+    std::vector<Symbol> queries(LOOKUPS);
+    for (auto& query : queries) {
+      query = names[random() % count];
+    }
+
+    size_t found = 0;
+    auto seconds = timeIt([&]() {
+      for (auto name : queries) {
+        found += env->lookup(name).value == nullptr;
+      }
+    });
+
+    std::printf("%10d %12.4f %12.1f\n", count, seconds, seconds * 1e9 / found);
+  }
+
+  std::printf("\nCodegen with top-level variables:\n\n");
+  std::printf("%10s %12s %12s\n", "globals", "time (s)", "us/global");
+
+  for (auto count : {1000, 5000, 20'000}) {
+    ProgramParser parser(1);
+    auto ast = parser.parse(globalsProgram(count));
+
+    Eva eva;
+    auto seconds = timeIt([&]() { eva.generate(ast.view()); });
+
+    std::printf("%10d %12.4f %12.2f\n", count, seconds, seconds * 1e6 / count);
+  }
+
+  return 0;
+}
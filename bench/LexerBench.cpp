@@ -0,0 +1,56 @@
+/*
+ * Tokenizer scaling benchmark.
+ *
+ * Tokenizes generated programs from 1KB to 100MB and reports the
+ * throughput for each size; per-byte cost should stay flat.
+ *
+ * Usage: eva_lexer_bench [max size in MB]
+ */
+
+#include <cstdlib>
+#include <cstdio>
+
+#include "../src/parser/EvaParser.h"
+#include "Bench.h"
+
+using syntax::Tokenizer;
+using syntax::TokenType;
+
+static const std::string snippet = R"(
+(var (greeting string) "Hello")
+(begin
+  (var x 42)
+  (set x (+ x 10))
+  (printf "X: %d\n" x))
+)";
+
+int main(int argc, char const *argv[]) {
+  size_t maxSize = (argc > 1 ? std::atoi(argv[1]) : 100) * 1024 * 1024;
+
+#ifdef EVA_USE_REGEX_LEXER
+  std::printf("Lexer: regex\n\n");
+#else
+  std::printf("Lexer: DFA\n\n");
+#endif
+
+  std::printf("%8s %12s %12s %10s\n", "size", "tokens", "time (s)", "MB/s");
+
+  for (size_t size = 1024; size <= maxSize; size *= 10) {
+    auto program = generateProgram(snippet, size);
+
+    Tokenizer tokenizer;
+    size_t tokens = 0;
+
+    auto seconds = timeIt([&]() {
+      tokenizer.initString(program);
+      while (tokenizer.getNextToken().type != TokenType::__EOF) {
+        tokens++;
+      }
+    });
+
+    std::printf("%8s %12zu %12.4f %10.1f\n", formatSize(size).c_str(), tokens,
+                seconds, program.size() / seconds / (1024 * 1024));
+  }
+
+  return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Optimization pipeline benchmark.
+ *
+ * Compiles a program of long chains of variables and nested blocks at
+ * each optimization level, and reports the codegen and optimization time,
+ * the instruction count, and the runtime of its main function (JIT-ed).
+ * The program prints its values, so its stdout goes to /dev/null and the
+ * results are printed to stderr.
+ *
+ * Usage: eva_opt_bench [statements]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include "../src/Eva.h"
+#include "Bench.h"
+
+/*
+ * (var v0 0) (begin (var v1 v0) (set v0 v1) (begin (var v2 v1) ...)) ...
+ */
+static std::string chainProgram(int statements) {
+  std::string program = "(var v0 0)\n";
+  std::string previous = "v0";
+  auto open = 0;
+
+  for (auto i = 1; i < statements; i++) {
+    auto name = "v" + std::to_string(i);
+
+    // A new block every 8 variables.
+    if (i % 8 == 0) {
+      program += "(begin ";
+      open++;
+    }
+
+    program += "(var " + name + " " + previous + ") (set " + previous + " " + name + ")\n";
+    previous = name;
+
+    if (open > 0 && i % 64 == 0) {
+      program += "(printf \"%d\\n\" " + previous + ")";
+      program.append(open, ')');
+      open = 0;
+      previous = "v0";
+    }
+  }
+  program.append(open, ')');
+
+  return program;
+}
+
+static size_t countInstructions(const llvm::Module& module) {
+  size_t count = 0;
+  for (const auto& fn : module) {
+    count += fn.getInstructionCount();
+  }
+  return count;
+}
+
+/*
+ * JIT-compiles a copy of the module and returns the time of `calls` calls
+ * to its main function.
+ */
+static double timeMain(const llvm::Module& module, int calls) {
+  std::string ir;
+  llvm::raw_string_ostream out(ir);
+  module.print(out, nullptr);
+
+  auto ctx = std::make_unique<llvm::LLVMContext>();
+  llvm::SMDiagnostic error;
+  auto copy = llvm::parseIR(llvm::MemoryBufferRef(ir, "eva"), error, *ctx);
+
+  auto jit = llvm::cantFail(llvm::orc::LLJITBuilder().create());
+
+  // printf from the host process.
+  jit->getMainJITDylib().addGenerator(llvm::cantFail(
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix())));
+
+  llvm::cantFail(jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(copy), std::move(ctx))));
+
+#if LLVM_VERSION_MAJOR >= 15
+  auto main = llvm::cantFail(jit->lookup("main")).toPtr<int()>();
+#else
+  auto main = (int (*)()) llvm::cantFail(jit->lookup("main")).getAddress();
+#endif
+
+  return timeIt([&]() {
+    for (auto i = 0; i < calls; i++) {
+      main();
+    }
+  });
+}
+
+int main(int argc, char const *argv[]) {
+  auto statements = argc > 1 ? std::atoi(argv[1]) : 20'000;
+  constexpr auto CALLS = 1000;
+
+  if (!std::freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  ProgramParser parser(1);
+  auto ast = parser.parse(chainProgram(statements));
+
+  std::fprintf(stderr, "%d statements, main called %d times\n\n", statements, CALLS);
+  std::fprintf(stderr, "%8s %12s %12s %14s %12s\n", "level", "codegen (s)", "opt (s)", "instructions", "run (s)");
+
+  static const std::pair<const char*, OptLevel> levels[] = {
+    {"-O0", OptLevel::O0}, {"-Oquick", OptLevel::Quick}, {"-O1", OptLevel::O1},
+    {"-O2", OptLevel::O2}, {"-O3", OptLevel::O3}, {"-Os", OptLevel::Os},
+  };
+
+  for (auto& [name, level] : levels) {
+    EvaOptions options;
+    options.optLevel = level;
+
+    Eva eva(options);
+
+    auto codegenSeconds = timeIt([&]() { eva.generate(ast.view()); });
+    auto optSeconds = timeIt([&]() { eva.optimize(); });
+    auto runSeconds = timeMain(eva.getModule(), CALLS);
+
+    std::fprintf(stderr, "%8s %12.4f %12.4f %14zu %12.4f\n", name, codegenSeconds, optSeconds,
+                countInstructions(eva.getModule()), runSeconds);
+  }
+
+  return 0;
+}
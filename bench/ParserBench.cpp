@@ -0,0 +1,66 @@
+/*
+ * Parser throughput benchmark.
+ *
+ * Parses a small program repeatedly and reports the parsing throughput,
+ * then parses data tables (lists) of 1k to 100k rows; time per element
+ * should stay flat.
+ *
+ * Usage: eva_parser_bench [total size in MB]
+ */
+
+#include <cstdlib>
+#include <cstdio>
+
+#include "../src/parser/EvaParser.h"
+#include "Bench.h"
+
+using syntax::EvaParser;
+
+static const std::string snippet = R"(
+(var (greeting string) "Hello")
+(begin
+  (var x 42)
+  (set x (+ x (* 2 (- x 1))))
+  (printf "X: %d\n" x))
+)";
+
+int main(int argc, char const *argv[]) {
+  size_t total = (argc > 1 ? std::atoi(argv[1]) : 20) * 1024 * 1024;
+
+  // A small program, parsed until the total size is reached.
+  auto program = "(begin " + snippet + ")";
+  auto iterations = total / program.size() + 1;
+
+  EvaParser parser;
+  size_t forms = 0;
+
+  auto seconds = timeIt([&]() {
+    for (size_t i = 0; i < iterations; i++) {
+      parser.parse(program);
+      forms += parser.ast.root().size - 1;
+    }
+  });
+
+  auto bytes = (double) program.size() * iterations;
+
+  std::printf("%8s %12s %12s %10s\n", "size", "forms", "time (s)", "MB/s");
+  std::printf("%8s %12zu %12.4f %10.1f\n\n", formatSize(bytes).c_str(), forms,
+              seconds, bytes / seconds / (1024 * 1024));
+
+  std::printf("%8s %12s %12s\n", "rows", "time (s)", "ns/row");
+
+  for (size_t rows = 1000; rows <= 100000; rows *= 10) {
+    // (table (row 0 "name" value) (row 1 "name" value) ...)
+    std::string table = "(table";
+    for (size_t i = 0; i < rows; i++) {
+      table += " (row " + std::to_string(i) + " \"name\" value)";
+    }
+    table += ")";
+
+    auto tableSeconds = timeIt([&]() { parser.parse(table); });
+
+    std::printf("%8zu %12.4f %12.1f\n", rows, tableSeconds, tableSeconds * 1e9 / rows);
+  }
+
+  return 0;
+}
@@ -1,13 +1,10 @@
 # Compile file main:
-clang++ -o eva $(/opt/homebrew/Cellar/llvm/17.0.6_1/bin/llvm-config --cxxflags --ldflags --system-libs --libs core) -std=c++2b Eva.cpp
+clang++ -o eva $(/opt/homebrew/Cellar/llvm/17.0.6_1/bin/llvm-config --cxxflags --ldflags --system-libs --libs core bitwriter passes orcjit native) -std=c++2b Eva.cpp
 
-# Run main:
-./eva
-
-# Execute generated IR:
-/opt/homebrew/Cellar/llvm/17.0.6_1/bin/lli out.ll
+# Compile and run the program in-process (JIT):
+./eva --run
 
 # Print result:
 echo $?
 
-printf "\n"
\ No newline at end of file
+printf "\n"
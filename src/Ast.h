@@ -0,0 +1,334 @@
+/*
+ * Compact AST stored in an arena.
+ */
+
+#ifndef EVA_AST_H
+#define EVA_AST_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SymbolTable.h"
+
+/*
+ * Index of a node in the AST arena.
+ */
+using NodeId = uint32_t;
+
+// Expression Type
+enum class ExprType : uint8_t {
+  NUMBER,
+  STRING,
+  SYMBOL,
+  LIST
+};
+
+/*
+ * Expression: a tagged 12-byte node. Symbols are interned, string contents
+ * are `size` characters in the arena, and list children are a span of
+ * `size` node IDs in the arena.
+ */
+struct Expr {
+  ExprType type;
+
+  // Number of children (lists), or of characters (strings).
+  uint32_t size;
+
+  union {
+    int number;
+    Symbol symbol;
+    uint32_t first;  // First child index (lists), or character (strings).
+  };
+};
+
+/*
+ * Read-only view of an AST: the node, child and string arrays of an
+ * arena, or of a mapped AST cache file.
+ */
+class AstView {
+ public:
+
+  AstView() = default;
+
+  AstView(std::span<const Expr> nodes, std::span<const NodeId> children, std::string_view strings, NodeId root)
+      : nodes_(nodes), children_(children), strings_(strings), root_(root) {}
+
+  /*
+   * Returns a node.
+   */
+  const Expr& operator[](NodeId id) const {
+    return nodes_[id];
+  }
+
+  /*
+   * Returns the child node IDs of a list.
+   */
+  std::span<const NodeId> children(const Expr& list) const {
+    return children_.subspan(list.first, list.size);
+  }
+
+  /*
+   * Returns the contents of a string.
+   */
+  std::string_view string(const Expr& node) const {
+    return strings_.substr(node.first, node.size);
+  }
+
+  /*
+   * Returns the ID of a node of this AST.
+   */
+  NodeId idOf(const Expr& node) const {
+    return &node - nodes_.data();
+  }
+
+  /*
+   * Returns the i-th child of a list.
+   */
+  const Expr& child(const Expr& list, size_t i) const {
+    return nodes_[children_[list.first + i]];
+  }
+
+  /*
+   * Returns the root expression.
+   */
+  const Expr& root() const {
+    return nodes_[root_];
+  }
+
+  NodeId rootId() const {
+    return root_;
+  }
+
+  /*
+   * Number of nodes.
+   */
+  size_t size() const {
+    return nodes_.size();
+  }
+
+  std::span<const Expr> nodes() const {
+    return nodes_;
+  }
+
+  std::span<const NodeId> childIds() const {
+    return children_;
+  }
+
+  std::string_view strings() const {
+    return strings_;
+  }
+
+ private:
+
+  std::span<const Expr> nodes_;
+
+  std::span<const NodeId> children_;
+
+  std::string_view strings_;
+
+  NodeId root_ = 0;
+};
+
+/*
+ * AST arena: all nodes, child lists and string contents of a program in
+ * three contiguous buffers, freed in one shot.
+ */
+class Ast {
+ public:
+
+  /*
+   * Returns a node.
+   */
+  const Expr& operator[](NodeId id) const {
+    return nodes_[id];
+  }
+
+  /*
+   * Returns the child node IDs of a list.
+   */
+  std::span<const NodeId> children(const Expr& list) const {
+    return {children_.data() + list.first, list.size};
+  }
+
+  /*
+   * Returns the i-th child of a list.
+   */
+  const Expr& child(const Expr& list, size_t i) const {
+    return nodes_[children_[list.first + i]];
+  }
+
+  /*
+   * Returns the contents of a string.
+   */
+  std::string_view string(const Expr& node) const {
+    return std::string_view(strings_).substr(node.first, node.size);
+  }
+
+  /*
+   * Returns the root expression.
+   */
+  const Expr& root() const {
+    return nodes_[root_];
+  }
+
+  NodeId rootId() const {
+    return root_;
+  }
+
+  /*
+   * Returns a read-only view of the arena, rooted at the given node.
+   */
+  AstView view(NodeId root) const {
+    return {nodes_, children_, strings_, root};
+  }
+
+  AstView view() const {
+    return view(root_);
+  }
+
+  void setRoot(NodeId id) {
+    root_ = id;
+  }
+
+  /*
+   * Number of nodes.
+   */
+  size_t size() const {
+    return nodes_.size();
+  }
+
+  NodeId addNumber(int number) {
+    return addNode_(Expr{.type = ExprType::NUMBER, .size = 0, .number = number});
+  }
+
+  /*
+   * Adds a string, copying its contents into the arena.
+   */
+  NodeId addString(std::string_view contents) {
+    auto first = (uint32_t) strings_.size();
+    strings_.append(contents);
+
+    return addNode_(Expr{.type = ExprType::STRING, .size = (uint32_t) contents.size(), .first = first});
+  }
+
+  NodeId addSymbol(Symbol symbol) {
+    return addNode_(Expr{.type = ExprType::SYMBOL, .size = 0, .symbol = symbol});
+  }
+
+  /*
+   * Lists are built bottom-up by the parser: `beginList` marks the start
+   * of the list entries, `addListEntry` adds each child, and `addList`
+   * moves the entries into the arena as one contiguous span.
+   */
+  uint32_t beginList() {
+    openLists_++;
+    return pending_.size();
+  }
+
+  void addListEntry(NodeId id) {
+    pending_.push_back(id);
+  }
+
+  NodeId addList(uint32_t start) {
+    auto first = (uint32_t) children_.size();
+    auto size = (uint32_t) (pending_.size() - start);
+
+    children_.insert(children_.end(), pending_.begin() + start, pending_.end());
+    pending_.resize(start);
+    openLists_--;
+
+    return addNode_(Expr{.type = ExprType::LIST, .size = size, .first = first});
+  }
+
+  /*
+   * Adds a list of the given children.
+   */
+  NodeId addList(std::span<const NodeId> children) {
+    auto start = beginList();
+    pending_.insert(pending_.end(), children.begin(), children.end());
+    return addList(start);
+  }
+
+  /*
+   * Number of lists being parsed (the nesting depth).
+   */
+  uint32_t openLists() const {
+    return openLists_;
+  }
+
+  /*
+   * Appends all nodes of another AST, returning the offset of its node IDs
+   * in this one.
+   */
+  NodeId append(const Ast& other) {
+    auto nodeBase = (NodeId) nodes_.size();
+    auto childBase = (uint32_t) children_.size();
+    auto stringBase = (uint32_t) strings_.size();
+
+    for (auto node : other.nodes_) {
+      if (node.type == ExprType::LIST) {
+        node.first += childBase;
+      } else if (node.type == ExprType::STRING) {
+        node.first += stringBase;
+      }
+      nodes_.push_back(node);
+    }
+
+    for (auto child : other.children_) {
+      children_.push_back(child + nodeBase);
+    }
+
+    strings_ += other.strings_;
+
+    return nodeBase;
+  }
+
+  /*
+   * Frees all nodes.
+   */
+  void clear() {
+    clearNodes();
+    pending_.clear();
+    openLists_ = 0;
+    root_ = 0;
+  }
+
+  /*
+   * Frees all built nodes, keeping the lists being parsed.
+   */
+  void clearNodes() {
+    nodes_.clear();
+    children_.clear();
+    strings_.clear();
+  }
+
+ private:
+
+  NodeId addNode_(const Expr& node) {
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  // Nodes
+  std::vector<Expr> nodes_;
+
+  // Child node IDs of all lists, one span per list.
+  std::vector<NodeId> children_;
+
+  // Contents of all strings, one span per string.
+  std::string strings_;
+
+  // Entries of the lists being parsed.
+  std::vector<NodeId> pending_;
+
+  // Number of lists being parsed.
+  uint32_t openLists_ = 0;
+
+  // Root node
+  NodeId root_ = 0;
+};
+
+#endif //EVA_AST_H
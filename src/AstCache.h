@@ -0,0 +1,334 @@
+/*
+ * Binary cache of parsed ASTs, keyed by a hash of the source.
+ */
+
+#ifndef EVA_AST_CACHE_H
+#define EVA_AST_CACHE_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include "Ast.h"
+#include "SymbolMap.h"
+
+static_assert(std::is_trivially_copyable_v<Expr> && sizeof(Expr) == 12,
+              "Expr nodes are written to the AST cache as raw bytes");
+
+/*
+ * Cache file layout (native byte order, 4-byte aligned sections):
+ *
+ *   AstCacheHeader
+ *   Expr     nodes[nodesCount]
+ *   NodeId   children[childrenCount]
+ *   uint32_t nameOffsets[symbolsCount + 1]
+ *   char     names[namesSize]
+ *   char     strings[stringsSize]
+ *
+ * Strings are spans of the string contents, as in the AST arena. Symbols
+ * in the nodes are IDs into the cached names: only the names the AST
+ * uses, numbered densely in order of first use, so the file does not
+ * depend on the rest of the writer's symbol table. The children of a list
+ * are nodes before it, so an AST has no cycles.
+ */
+struct AstCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t exprSize;
+  uint64_t sourceHash;
+  uint64_t sourceSize;
+  uint32_t nodesCount;
+  uint32_t childrenCount;
+  uint32_t symbolsCount;
+  uint32_t namesSize;
+  uint32_t stringsSize;
+  NodeId root;
+  uint8_t littleEndian;
+  uint8_t reserved[3];
+};
+
+static_assert(sizeof(AstCacheHeader) % 4 == 0);
+
+/*
+ * AST loaded from a cache file. The nodes are used in place from the
+ * mapped file.
+ */
+class MappedAst {
+ public:
+
+  MappedAst(llvm::sys::fs::mapped_file_region region, AstView view)
+      : region_(std::move(region)), view_(view) {}
+
+  AstView view() const {
+    return view_;
+  }
+
+ private:
+
+  llvm::sys::fs::mapped_file_region region_;
+
+  AstView view_;
+};
+
+class AstCache {
+ public:
+
+  /*
+   * Cache format version, bumped on any change to the layout or to the
+   * AST node encoding.
+   */
+  static constexpr uint32_t VERSION = 4;
+
+  explicit AstCache(std::string directory): directory_(std::move(directory)) {}
+
+  /*
+   * Returns the cached AST of a source, or nothing if there is no valid
+   * cache entry for it.
+   */
+  std::optional<MappedAst> load(std::string_view source) const {
+    auto hash = hashSource_(source);
+    auto path = pathFor_(hash);
+
+    auto file = llvm::sys::fs::openNativeFileForRead(path);
+    if (!file) {
+      llvm::consumeError(file.takeError());
+      return std::nullopt;
+    }
+
+    llvm::sys::fs::file_status status;
+    auto ec = llvm::sys::fs::status(*file, status);
+
+    std::optional<llvm::sys::fs::mapped_file_region> region;
+    if (!ec && status.getSize() >= sizeof(AstCacheHeader)) {
+      // Private mapping: symbol IDs may be remapped in place below.
+      region.emplace(*file, llvm::sys::fs::mapped_file_region::priv, status.getSize(), 0, ec);
+    }
+    llvm::sys::fs::closeFile(*file);
+
+    if (!region || ec) {
+      return std::nullopt;
+    }
+
+    auto data = region->data();
+    auto size = region->size();
+
+    AstCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (!isValidHeader_(header, size, hash, source.size())) {
+      return std::nullopt;
+    }
+
+    auto nodes = reinterpret_cast<Expr*>(data + sizeof(header));
+    auto children = reinterpret_cast<NodeId*>(nodes + header.nodesCount);
+    auto nameOffsets = reinterpret_cast<uint32_t*>(children + header.childrenCount);
+    auto names = reinterpret_cast<const char*>(nameOffsets + header.symbolsCount + 1);
+    auto strings = std::string_view(names + header.namesSize, header.stringsSize);
+
+    // Interns the cached names. If their IDs match the cached ones (the
+    // well-known symbols only, for example), the nodes are used as written.
+    std::vector<Symbol> symbols(header.symbolsCount);
+    auto remap = false;
+
+    for (uint32_t i = 0; i < header.symbolsCount; i++) {
+      auto start = nameOffsets[i];
+      auto end = nameOffsets[i + 1];
+
+      if (start > end || end > header.namesSize) {
+        return std::nullopt;
+      }
+
+      symbols[i] = intern(std::string_view(names + start, end - start));
+      remap |= symbols[i] != i;
+    }
+
+    for (uint32_t i = 0; i < header.nodesCount; i++) {
+      auto& node = nodes[i];
+
+      switch (node.type) {
+        case ExprType::NUMBER:
+          break;
+        case ExprType::STRING:
+          if (node.first > header.stringsSize || node.size > header.stringsSize - node.first) {
+            return std::nullopt;
+          }
+          break;
+        case ExprType::SYMBOL:
+          if (node.symbol >= header.symbolsCount) {
+            return std::nullopt;
+          }
+          if (remap) {
+            node.symbol = symbols[node.symbol];
+          }
+          break;
+        case ExprType::LIST:
+          if (node.first > header.childrenCount || node.size > header.childrenCount - node.first) {
+            return std::nullopt;
+          }
+          for (auto child : std::span(children + node.first, node.size)) {
+            if (child >= i) {
+              return std::nullopt;
+            }
+          }
+          break;
+        default:
+          return std::nullopt;
+      }
+    }
+
+    for (uint32_t i = 0; i < header.childrenCount; i++) {
+      if (children[i] >= header.nodesCount) {
+        return std::nullopt;
+      }
+    }
+
+    AstView view({nodes, header.nodesCount}, {children, header.childrenCount}, strings, header.root);
+
+    return MappedAst(std::move(*region), view);
+  }
+
+  /*
+   * Writes the AST of a source to the cache. The file is written under a
+   * temporary name and renamed, so concurrent readers never see a partial
+   * entry. Failures only mean a cache miss next time, and are ignored.
+   */
+  void store(std::string_view source, AstView ast) const {
+    if (llvm::sys::fs::create_directories(directory_)) {
+      return;
+    }
+
+    auto hash = hashSource_(source);
+    auto path = pathFor_(hash);
+
+    // Names of the symbols used, and the nodes with their cached IDs. The
+    // nodes are copied field by field into zeroed ones, so that no padding
+    // bytes of the arena get into the file.
+    std::vector<Expr> nodes(ast.size());
+    SymbolMap<uint32_t> cachedIds;
+
+    std::vector<uint32_t> nameOffsets {0};
+    std::string names;
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+      const auto& node = ast[i];
+      auto& cached = nodes[i];
+
+      cached.type = node.type;
+      cached.size = node.size;
+      cached.first = node.first;
+
+      if (node.type != ExprType::SYMBOL) {
+        continue;
+      }
+
+      auto id = cachedIds.find(node.symbol);
+      if (!id) {
+        id = &cachedIds.set(node.symbol, nameOffsets.size() - 1);
+        names += symbolName(node.symbol);
+        nameOffsets.push_back(names.size());
+      }
+      cached.symbol = *id;
+    }
+
+    auto symbolsCount = (uint32_t) (nameOffsets.size() - 1);
+
+    AstCacheHeader header{};
+    std::memcpy(header.magic, MAGIC_, sizeof(header.magic));
+    header.version = VERSION;
+    header.exprSize = sizeof(Expr);
+    header.sourceHash = hash;
+    header.sourceSize = source.size();
+    header.nodesCount = ast.size();
+    header.childrenCount = ast.childIds().size();
+    header.symbolsCount = symbolsCount;
+    header.namesSize = names.size();
+    header.stringsSize = ast.strings().size();
+    header.root = ast.rootId();
+    header.littleEndian = std::endian::native == std::endian::little;
+
+    int fd;
+    llvm::SmallString<128> tempPath;
+    if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tempPath)) {
+      return;
+    }
+
+    {
+      llvm::raw_fd_ostream out(fd, /* shouldClose */ true);
+
+      write_(out, &header, sizeof(header));
+      write_(out, nodes.data(), nodes.size() * sizeof(Expr));
+      write_(out, ast.childIds().data(), ast.childIds().size_bytes());
+      write_(out, nameOffsets.data(), nameOffsets.size() * sizeof(uint32_t));
+      write_(out, names.data(), names.size());
+      write_(out, ast.strings().data(), ast.strings().size());
+
+      out.close();
+      if (out.has_error()) {
+        out.clear_error();
+        llvm::sys::fs::remove(tempPath);
+        return;
+      }
+    }
+
+    if (llvm::sys::fs::rename(tempPath, path)) {
+      llvm::sys::fs::remove(tempPath);
+    }
+  }
+
+ private:
+
+  static constexpr char MAGIC_[8] = {'E', 'V', 'A', 'A', 'S', 'T', 0, 0};
+
+  static uint64_t hashSource_(std::string_view source) {
+    return llvm::xxHash64(llvm::StringRef(source.data(), source.size()));
+  }
+
+  std::string pathFor_(uint64_t hash) const {
+    llvm::SmallString<128> path(directory_);
+    llvm::sys::path::append(path, llvm::utohexstr(hash, /* lowerCase */ true) + ".ast");
+    return std::string(path);
+  }
+
+  static bool isValidHeader_(const AstCacheHeader& header, size_t fileSize, uint64_t hash, size_t sourceSize) {
+    if (std::memcmp(header.magic, MAGIC_, sizeof(header.magic)) != 0 ||
+        header.version != VERSION ||
+        header.exprSize != sizeof(Expr) ||
+        header.littleEndian != (std::endian::native == std::endian::little) ||
+        header.sourceHash != hash ||
+        header.sourceSize != sourceSize) {
+      return false;
+    }
+
+    auto expected = sizeof(AstCacheHeader) +
+                    (uint64_t) header.nodesCount * sizeof(Expr) +
+                    (uint64_t) header.childrenCount * sizeof(NodeId) +
+                    ((uint64_t) header.symbolsCount + 1) * sizeof(uint32_t) +
+                    header.namesSize +
+                    header.stringsSize;
+
+    return expected == fileSize && header.root < header.nodesCount;
+  }
+
+  static void write_(llvm::raw_ostream& out, const void* data, size_t size) {
+    out.write(static_cast<const char*>(data), size);
+  }
+
+  // Directory of the cache files.
+  std::string directory_;
+};
+
+#endif //EVA_AST_CACHE_H
@@ -5,61 +5,186 @@
 #ifndef EVA_ENVIRONMENT_H
 #define EVA_ENVIRONMENT_H
 
-#include <map>
-#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "Logger.h"
+#include "SymbolMap.h"
 #include "llvm/IR/Value.h"
 
+/*
+ * Binding of a name: a value (a global variable, read and written in
+ * memory, or a function), or a local variable, whose values are built
+ * as SSA (see SsaBuilder).
+ */
+struct Binding {
+  Binding(llvm::Value* value = nullptr): value(value) {}
+
+  static Binding local(uint32_t variable) {
+    Binding binding;
+    binding.variable = variable;
+    return binding;
+  }
+
+  bool isLocal() const {
+    return value == nullptr;
+  }
+
+  // Bound value, or null for a local.
+  llvm::Value* value;
+
+  // SSA variable number of a local.
+  uint32_t variable = 0;
+};
+
 /*
  * Environment: names storage
+ *
+ * Bindings are kept in slots, in definition order, so a variable with a
+ * lexical address (see Resolver) is fetched without a name lookup.
+ * Environments live in an EnvironmentStack, and link to their parent
+ * without owning it.
  */
- class Environment: public std::enable_shared_from_this<Environment> {
+class Environment {
  public:
 
   /*
-   * Creates an environment with the given record.
+   * Creates an empty environment.
    */
-  Environment(std::map<std::string, llvm::Value*> record,
-              std::shared_ptr<Environment> parent): record_(record), parent_(parent) {}
+  explicit Environment(Environment* parent): parent_(parent) {}
 
-  // Creates a variable with the given name and value.
-  llvm::Value* define(const std::string& name, llvm::Value* value) {
-    record_[name] = value;
-    return value;
+  // Creates a variable with the given name and binding in the next slot.
+  Binding define(Symbol name, Binding binding) {
+    record_.set(name, slots_.size());
+    slots_.push_back(binding);
+    return binding;
   }
 
   /*
-   * Returns the value of a defined variable, or throws
-   * if the variable is not defined.
+   * Returns the binding of a defined variable, or throws
+   * if the variable is not defined. One hash probe per scope.
    */
-  llvm::Value* lookup(const std::string& name) {
-    return resolve(name)->record_[name];
-  }
+  Binding lookup(Symbol name) {
+    for (auto env = this; env != nullptr; env = env->parent_) {
+      if (auto slot = env->record_.find(name)) {
+        return env->slots_[*slot];
+      }
+    }
 
- private:
+    DIE << "Variable \"" << symbolName(name) << "\" is not defined.";
+    return {};
+  }
 
-  /* Returns specific environment in which a variable is defined, or
-   * throws if a variable is not defined.
+  /*
+   * Returns the binding in a slot of the environment `depth` levels up.
    */
-  std::shared_ptr<Environment> resolve(const std::string& name) {
-    if (record_.contains(name)) {
-      return shared_from_this();
+  Binding lookup(uint32_t depth, uint32_t slot) const {
+    auto env = this;
+    while (depth-- > 0) {
+      env = env->parent_;
     }
+    return env->slots_[slot];
+  }
 
-    if (parent_ == nullptr) {
-      DIE << "Variable \"" << name << "\" is not defined.";
+  /*
+   * Returns the slot of a variable defined in this environment.
+   */
+  std::optional<uint32_t> slotOf(Symbol name) const {
+    if (auto slot = record_.find(name)) {
+      return *slot;
     }
+    return std::nullopt;
+  }
 
-    return parent_->resolve(name);
+  /*
+   * Empties the environment for reuse, keeping its storage.
+   */
+  void reset(Environment* parent) {
+    record_.clear();
+    slots_.clear();
+    parent_ = parent;
   }
 
+ private:
+
+  // Name -> latest slot
+  SymbolMap<uint32_t> record_;
+
   // Bindings storage
-  std::map<std::string, llvm::Value*> record_;
+  std::vector<Binding> slots_;
 
   // Parent link
-  std::shared_ptr<Environment> parent_;
+  Environment* parent_;
+};
+
+/*
+ * Stack of environments with block lifetimes: pushed on block entry and
+ * popped on exit. Popped environments are kept and reused, so entering a
+ * block allocates nothing once the stack has reached its depth. New ones
+ * are created in chunks, each as large as all the previous ones, so a
+ * stack of depth N makes O(log N) allocations, and nested environments
+ * are mostly adjacent in memory. The bottom environment is the global
+ * one.
+ */
+class EnvironmentStack {
+ public:
+
+  EnvironmentStack() {
+    push(nullptr);
+  }
+
+  /*
+   * The global environment.
+   */
+  Environment* global() const {
+    return environments_.front();
+  }
+
+  /*
+   * Pushes an empty environment. The parent is the current innermost one.
+   */
+  Environment* push(Environment* parent) {
+    if (size_ == environments_.size()) {
+      add_(parent);
+    } else {
+      environments_[size_]->reset(parent);
+    }
+    return environments_[size_++];
+  }
+
+  /*
+   * Pops the innermost environment.
+   */
+  void pop() {
+    size_--;
+  }
+
+ private:
+
+  /*
+   * Creates an environment at the top of the stack, in a new chunk if the
+   * last one is full.
+   */
+  void add_(Environment* parent) {
+    if (chunks_.empty() || chunks_.back().size() == chunks_.back().capacity()) {
+      chunks_.emplace_back().reserve(std::max(environments_.size(), MIN_CHUNK_SIZE));
+    }
+    environments_.push_back(&chunks_.back().emplace_back(parent));
+  }
+
+  static constexpr size_t MIN_CHUNK_SIZE = 8;
+
+  // Chunks of environments, never reallocated, so the addresses of the
+  // environments are stable.
+  std::vector<std::vector<Environment>> chunks_;
+
+  // Environments in stack order; the first `size_` are live.
+  std::vector<Environment*> environments_;
+
+  size_t size_ = 0;
 };
 
-#endif // EVA_ENVIRONMENT_H
\ No newline at end of file
+#endif // EVA_ENVIRONMENT_H
@@ -5,51 +5,350 @@
 #ifndef EVA_EVA_H
 #define EVA_EVA_H
 
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <map>
 #include <string>
-#include <regex>
+#include <string_view>
+#include <vector>
 
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/IR/BasicBlock.h>
-
-#include "parser/EvaParser.h"
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#if LLVM_VERSION_MAJOR >= 17
+#include <llvm/TargetParser/Host.h>
+#else
+#include <llvm/Support/Host.h>
+#endif
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
+
+#include "parser/ProgramParser.h"
+#include "AstCache.h"
 #include "Environment.h"
+#include "Resolver.h"
+#include "SsaBuilder.h"
+#include "StringPool.h"
+#include "TypeChecker.h"
 
-using syntax::EvaParser;
+using syntax::ProgramParser;
 
 /*
  * Environment type.
  */
-using Env = std::shared_ptr<Environment>;
+using Env = Environment*;
+
+/*
+ * Optimization level: LLVM's default pipelines (-O0..-O3, -Os), or Quick,
+ * a function-level SROA/mem2reg/instcombine pass for fast builds.
+ */
+enum class OptLevel {
+  O0,
+  O1,
+  O2,
+  O3,
+  Os,
+  Quick
+};
+
+/*
+ * Compiler options.
+ */
+struct EvaOptions {
+  // Optimization level of the generated module.
+  OptLevel optLevel = OptLevel::O0;
+
+  // Generate native code for the host CPU and its features (-march=native)
+  // rather than a portable baseline of the host architecture.
+  bool nativeCpu = false;
+
+  // Directory of the parsed AST cache, disabled if empty.
+  std::string astCacheDir;
+
+  // Compile each top-level form as soon as it is parsed, keeping only
+  // that form's AST in memory (no parallel parsing and no AST cache).
+  bool streaming = false;
+
+  // Merge string constants that are suffixes of others into them.
+  bool mergeStrings = false;
+};
+
+/*
+ * Output of a compiled program: nothing, textual IR (.ll), bitcode (.bc),
+ * a native object file, or a native executable.
+ */
+enum class EmitMode {
+  None,
+  IR,
+  Bitcode,
+  Object,
+  Executable
+};
+
+/*
+ * Output options, per compiled program.
+ */
+struct EmitOptions {
+  EmitMode mode = EmitMode::IR;
+
+  // Output file, or the mode's default (./out.ll, ./out.bc, ./out.o, ./out)
+  // if empty.
+  std::string path;
+
+  // Also print the generated IR to stdout.
+  bool printIR = false;
+};
 
 class Eva {
  public:
 
-  Eva(): parser(std::make_unique<EvaParser>()) {
+  Eva(const EvaOptions& options = {})
+      : parser(std::make_unique<ProgramParser>()),
+        streaming(options.streaming),
+        optLevel(options.optLevel),
+        nativeCpu(options.nativeCpu),
+        mergeStrings(options.mergeStrings),
+        resolver([this](Symbol name) { return findSpecialForm(name) != nullptr; }) {
+    if (!options.astCacheDir.empty()) {
+      astCache = std::make_unique<AstCache>(options.astCacheDir);
+    }
+
     moduleInit();
     setupExternalFunctions();
     setupGlobalEnvironment();
+    setupSpecialForms();
   }
 
+  Eva(const Eva&) = delete;
+  Eva& operator=(const Eva&) = delete;
+
   /*
-   * Executes a program.
+   * Executes a program: compiles it and writes the output selected by
+   * the emit options.
    */
-  void exec(const std::string &program) {
-    // 1. Parse the program:
-    auto ast = parser->parse("(begin " + program + ")");
+  void exec(const std::string &program, const EmitOptions& emit = {}) {
+    auto native = emit.mode == EmitMode::Object || emit.mode == EmitMode::Executable;
+
+    // 1-2. Parse and compile to LLVM IR:
+    generate(program);
 
-    // 2. Compile to LLVM IR:
-    compile(ast);
+    // 3. Optimize (for the target, when generating native code):
+    if (native) {
+      setupTargetMachine();
+    }
+    optimize();
 
     // Print generated code.
-    module->print(llvm::outs(), nullptr);
-    std::cout << "\n";
+    if (emit.printIR) {
+      module->print(llvm::outs(), nullptr);
+      llvm::outs() << "\n";
+    }
 
-    // 3. Save module IR to file:
-    saveModuleToFile("./out.ll");
+    // 4. Save the output:
+    auto path = emit.path.empty() ? defaultOutputPath(emit.mode) : emit.path;
+
+    switch (emit.mode) {
+      case EmitMode::None:
+        break;
+      case EmitMode::IR:
+        saveModuleToFile(path);
+        break;
+      case EmitMode::Bitcode:
+        saveBitcodeToFile(path);
+        break;
+      case EmitMode::Object:
+        emitObjectFile(path);
+        break;
+      case EmitMode::Executable: {
+        // Through a temporary object file, removed once linked.
+        llvm::SmallString<128> objectPath;
+        if (auto errorCode = llvm::sys::fs::createTemporaryFile("eva", "o", objectPath)) {
+          DIE << "Cannot create a temporary object file: " << errorCode.message();
+        }
+        emitObjectFile(objectPath.str().str());
+        linkExecutable(objectPath.str().str(), path);
+        break;
+      }
+    }
+  }
+
+  /*
+   * Default output file of an emit mode.
+   */
+  static std::string defaultOutputPath(EmitMode mode) {
+    switch (mode) {
+      case EmitMode::IR:
+        return "./out.ll";
+      case EmitMode::Bitcode:
+        return "./out.bc";
+      case EmitMode::Object:
+        return "./out.o";
+      case EmitMode::Executable:
+        return "./out";
+      default:
+        return "";
+    }
+  }
+
+  /*
+   * Compiles a program and runs it in this process with the ORC JIT,
+   * returning the exit code of main. External functions (printf) are
+   * resolved against the host process. The module is handed over to the
+   * JIT, so an Eva instance runs one program.
+   */
+  int run(const std::string &program) {
+    // 1-2. Parse and compile to LLVM IR:
+    generate(program);
+
+    // 3. Optimize:
+    optimize();
+
+    // 4. JIT-compile and call main:
+    return runMain();
+  }
+
+  /*
+   * Generates LLVM IR for a program, without printing or saving it.
+   */
+  void generate(const std::string &program) {
+    // 1-2. Parse and compile each top-level form in turn:
+    if (streaming) {
+      compileStreaming(program);
+    }
+
+    // 1-2. Compile to LLVM IR from the cached AST of the program:
+    else if (auto cached = astCache ? astCache->load(program) : std::nullopt) {
+      compile(cached->view());
+    } else {
+      // 1. Parse the program (top-level forms are parsed in parallel):
+      auto ast = parser->parse(program);
+
+      if (astCache) {
+        astCache->store(program, ast.view());
+      }
+
+      // 2. Compile to LLVM IR (the AST is freed right after):
+      compile(ast.view());
+    }
+  }
+
+  /*
+   * Generates LLVM IR for a parsed program.
+   */
+  void generate(AstView program) {
+    compile(program);
+  }
+
+  /*
+   * Verifies the generated module, and runs the optimization pipeline of
+   * the configured level on it.
+   */
+  void optimize() {
+    if (llvm::verifyModule(*module, &llvm::errs())) {
+      DIE << "Generated module is invalid.";
+    }
+
+    if (optLevel == OptLevel::O0) {
+      return;
+    }
+
+    llvm::LoopAnalysisManager loopAnalyses;
+    llvm::FunctionAnalysisManager functionAnalyses;
+    llvm::CGSCCAnalysisManager cgsccAnalyses;
+    llvm::ModuleAnalysisManager moduleAnalyses;
+
+    llvm::PassBuilder passBuilder(targetMachine.get());
+    passBuilder.registerModuleAnalyses(moduleAnalyses);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalyses);
+    passBuilder.registerFunctionAnalyses(functionAnalyses);
+    passBuilder.registerLoopAnalyses(loopAnalyses);
+    passBuilder.crossRegisterProxies(loopAnalyses, functionAnalyses, cgsccAnalyses, moduleAnalyses);
+
+    llvm::ModulePassManager passes;
+
+    if (optLevel == OptLevel::Quick) {
+      // Locals are built as SSA values already; allocas of other code
+      // generators (such as special forms) are promoted, then folded.
+      llvm::FunctionPassManager functionPasses;
+#if LLVM_VERSION_MAJOR >= 16
+      functionPasses.addPass(llvm::SROAPass(llvm::SROAOptions::ModifyCFG));
+#else
+      functionPasses.addPass(llvm::SROAPass());
+#endif
+      functionPasses.addPass(llvm::PromotePass());
+      functionPasses.addPass(llvm::InstCombinePass());
+
+      passes.addPass(llvm::createModuleToFunctionPassAdaptor(std::move(functionPasses)));
+    } else {
+      passes = passBuilder.buildPerModuleDefaultPipeline(getPassBuilderLevel(optLevel));
+    }
+
+    passes.run(*module, moduleAnalyses);
+  }
+
+  /*
+   * The generated module.
+   */
+  const llvm::Module& getModule() const {
+    return *module;
+  }
+
+  /*
+   * Special form: compiles a list `(<name> <args>)`.
+   */
+  using SpecialForm = std::function<llvm::Value*(const Expr& expr, Env env)>;
+
+  /*
+   * Registers a compile-time special form, replacing any form of the same
+   * name. Forms are looked up by the interned name of the list head, in
+   * constant time regardless of how many are defined.
+   */
+  void defineSpecialForm(std::string_view name, SpecialForm form) {
+    auto symbol = intern(name);
+
+    if (symbol >= specialForms.size()) {
+      specialForms.resize(symbol + 1);
+    }
+    specialForms[symbol] = std::move(form);
+  }
+
+  /*
+   * Compiles a subexpression of the current program (for special forms).
+   */
+  llvm::Value* compileExpr(const Expr& expr, Env env) {
+    return gen(expr, env);
+  }
+
+  /*
+   * The program being compiled (for special forms).
+   */
+  const AstView& currentAst() const {
+    return ast;
+  }
+
+  /*
+   * IR builder at the current insertion point (for special forms).
+   */
+  llvm::IRBuilder<>& irBuilder() {
+    return *builder;
   }
 
  private:
@@ -57,21 +356,79 @@ class Eva {
   /*
    * Compiles an expression.
    */
-  void compile(const Expr& ast) {
+  void compile(AstView program) {
+    ast = program;
+
     // 1. Create main function.
-    fn = createFunction("main", llvm::FunctionType::get(/* return type */ builder->getInt32Ty(),
-                                                                          /* vararg */false), GlobalEnv);
+    createMain();
 
-    createGlobalVar("VERSION", builder->getInt32(42));
+    // 2. Resolve variables to their lexical addresses.
+    if (!resolver.resolve(program, *GlobalEnv)) {
+      reportUndefinedVariables();
+    }
 
-    // 2. Compile main body.
-    gen(ast, GlobalEnv);
+    // 3. Infer and check the types of expressions.
+    if (!typeChecker->check(program, resolver, *GlobalEnv)) {
+      reportTypeErrors();
+    }
+
+    // 4. Compile main body.
+    gen(program.root(), GlobalEnv);
+
+    builder->CreateRet(builder->getInt32(0));
+    strings->finish();
+
+    ast = {};
+  }
+
+  /*
+   * Compiles a program form by form, as the parser streams them. The forms
+   * share one block scope, as in the implicit `(begin <forms>)`.
+   */
+  void compileStreaming(const std::string& program) {
+    // 1. Create main function.
+    createMain();
+
+    // 2. Resolve, type and compile the main body, form by form.
+    auto programEnv = environments.push(GlobalEnv);
+    resolver.beginScope();
+    typeChecker->beginScope();
+
+    parser->parseForms(program, [&](AstView form) {
+      if (!resolver.resolve(form, *GlobalEnv)) {
+        reportUndefinedVariables();
+      }
+      if (!typeChecker->check(form, resolver, *GlobalEnv)) {
+        reportTypeErrors();
+      }
+
+      ast = form;
+      gen(form.root(), programEnv);
+    });
+
+    typeChecker->endScope();
+    resolver.endScope();
+    environments.pop();
 
     builder->CreateRet(builder->getInt32(0));
+    strings->finish();
+
+    ast = {};
+  }
+
+  /*
+   * Creates the main function.
+   */
+  void createMain() {
+    fn = createFunction("main", llvm::FunctionType::get(/* return type */ builder->getInt32Ty(),
+                                                                          /* vararg */false), GlobalEnv);
+
+    createGlobalVar("VERSION", builder->getInt32(42));
   }
 
   /*
-   * Main compile loop.
+   * Main compile loop. Nodes are visited in place in the AST, and the
+   * environment is passed by reference.
    */
   llvm::Value* gen(const Expr& expr, Env env) {
     switch (expr.type) {
@@ -85,101 +442,58 @@ class Eva {
        * Strings
        */
       case ExprType::STRING: {
-        // Unescape special characters. TODO: Support all characters or handle in parser.
-        auto re = std::regex("\\\\n");
-        auto str = std::regex_replace(expr.string, re, "\n");
-        return builder->CreateGlobalStringPtr(str);
+        // Escape sequences are decoded by the parser.
+        return strings->get(ast.string(expr));
       }
       case ExprType::SYMBOL: {
         /*
          * Boolean
          */
-        if (expr.string == "true" || expr.string == "false") {
-          return builder->getInt1(expr.string == "true");
+        if (expr.symbol == SYM_TRUE || expr.symbol == SYM_FALSE) {
+          return builder->getInt1(expr.symbol == SYM_TRUE);
         } else {
           /*
            * Variables
            */
-          auto varName = expr.string;
-          auto value = env->lookup(varName);
+          auto varName = expr.symbol;
+          auto binding = lookupVariable(expr, env);
 
           // Local Variables
-          if (auto localVar = llvm::dyn_cast<llvm::AllocaInst>(value)) {
-            return builder->CreateLoad(localVar->getType(), localVar, varName.c_str());
+          if (binding.isLocal()) {
+            return ssa.read(binding.variable, builder->GetInsertBlock());
           }
           // Global Variables
-          else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(value)) {
-            return builder->CreateLoad(globalVar->getInitializer()->getType(), globalVar, varName.c_str());
+          else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(binding.value)) {
+            return builder->CreateLoad(globalVar->getValueType(), globalVar, symbolName(varName));
+          }
+          // Stack slots, bound by other forms
+          else if (auto localVar = llvm::dyn_cast<llvm::AllocaInst>(binding.value)) {
+            return builder->CreateLoad(localVar->getAllocatedType(), localVar, symbolName(varName));
           }
+          // Values bound by other forms
+          else if (!llvm::isa<llvm::Function>(binding.value)) {
+            return binding.value;
+          }
+
+          // Functions: rejected by the type checker.
+          DIE << "\"" << symbolName(varName) << "\" is not a variable.";
+          return nullptr;
         }
       }
       case ExprType::LIST: {
-        auto tag = expr.list[0];
+        // (): rejected by the type checker.
+        if (expr.size == 0) {
+          DIE << "An empty list is not an expression.";
+          return nullptr;
+        }
+
+        const auto& tag = ast.child(expr, 0);
         /*
-         * Special Cases.
+         * Special forms, dispatched by the head symbol.
          */
         if (tag.type == ExprType::SYMBOL) {
-          auto op = tag.string;
-
-          /*
-           * Variable declaration: (var x (+ y 10))
-           *
-           * Typed: (var (x number) 42)
-           *
-           * Locals are allocated on the stack.
-           */
-          if (op == "var") {
-            // TODO: Handle Generics
-            auto varNameDecl = expr.list[1];
-            auto varName = extractVarName(varNameDecl);
-            // Initializer
-            auto init = gen(expr.list[2], env);
-
-            // Type
-            auto varTy = extractVarType(varNameDecl);
-
-            // Variable
-            auto varBinding = allocVar(varName, varTy, env);
-
-            // Set value
-            return builder->CreateStore(init, varBinding);
-          } else if (op == "set") {
-            /*
-             * Variable update: (set x 100)
-             */
-            // Value
-            auto value = gen(expr.list[2], env);
-
-            auto varName = expr.list[1].string;
-
-            // Variable
-            auto varBinding = env->lookup(varName);
-
-            // Set value
-            return builder->CreateStore(value, varBinding);
-          } else if (op == "begin") {
-            /*
-             * Blocks (begin <expressions>)
-             */
-            auto blockEnv = std::make_shared<Environment>(std::map<std::string, llvm::Value*>{}, env);
-
-            llvm::Value *blockRes;
-            for (auto i = 1; i < expr.list.size(); i += 1) {
-              // Generate expression code.
-              blockRes = gen(expr.list[i], blockEnv);
-            }
-            return blockRes;
-          } else if (op == "printf") {
-            // printf extern function:
-            //
-            // (printf "Value: %d" 42)
-            auto printfFn = module->getFunction("printf");
-            std::vector<llvm::Value *> args;
-
-            for (auto i = 1; i < expr.list.size(); i += 1) {
-              args.push_back(gen(expr.list[i], env));
-            }
-            return builder->CreateCall(printfFn, args);
+          if (auto form = findSpecialForm(tag.symbol)) {
+            return (*form)(expr, env);
           }
         }
       }
@@ -190,45 +504,312 @@ class Eva {
   }
 
   /*
-   * Extracts variable or parameter type with i32 as default.
-   * x -> i32
-   * (x number) -> number
+   * Variable declaration: (var x (+ y 10))
+   *
+   * Typed: (var (x number) 42)
+   *
+   * Locals are SSA values: no storage is allocated.
+   */
+  llvm::Value* genVar(const Expr& expr, Env env) {
+    // TODO: Handle Generics
+    const auto& varNameDecl = ast.child(expr, 1);
+    auto varName = extractVarName(varNameDecl);
+    // Initializer
+    auto init = gen(ast.child(expr, 2), env);
+
+    // Type: declared or inferred, or the initializer's if it has no
+    // static type.
+    auto varTy = typeChecker->typeOf(ast.idOf(expr));
+    if (!varTy) {
+      varTy = init->getType();
+    }
+
+    // Variable
+    auto variable = ssa.addVariable(varName, varTy);
+    env->define(varName, Binding::local(variable));
+
+    // Set value
+    ssa.write(variable, builder->GetInsertBlock(), init);
+    return init;
+  }
+
+  /*
+   * Variable update: (set x 100)
+   */
+  llvm::Value* genSet(const Expr& expr, Env env) {
+    // Value
+    auto value = gen(ast.child(expr, 2), env);
+
+    const auto& varNameExpr = ast.child(expr, 1);
+
+    // Variable
+    auto binding = lookupVariable(varNameExpr, env);
+
+    // Set value
+    if (binding.isLocal()) {
+      ssa.write(binding.variable, builder->GetInsertBlock(), value);
+      return value;
+    }
+    if (!llvm::isa<llvm::GlobalVariable, llvm::AllocaInst>(binding.value)) {
+      DIE << "\"" << symbolName(varNameExpr.symbol) << "\" cannot be set.";
+    }
+    return builder->CreateStore(value, binding.value);
+  }
+
+  /*
+   * Binding of a variable reference: at its lexical address, or by name
+   * if it has a dynamic one.
+   */
+  Binding lookupVariable(const Expr& name, Env env) {
+    auto address = resolver.address(ast.idOf(name));
+
+    if (address.isDynamic()) {
+      return env->lookup(name.symbol);
+    }
+    return env->lookup(address.depth, address.slot);
+  }
+
+  /*
+   * Blocks (begin <expressions>)
    */
-  std::string extractVarName(const Expr& expr) {
-    return expr.type == ExprType::LIST ? expr.list[0].string : expr.string;
+  llvm::Value* genBegin(const Expr& expr, Env env) {
+    auto blockEnv = environments.push(env);
+
+    // An empty block is rejected by the type checker where its value is used.
+    llvm::Value *blockRes = builder->getInt32(0);
+    for (uint32_t i = 1; i < expr.size; i += 1) {
+      // Generate expression code.
+      blockRes = gen(ast.child(expr, i), blockEnv);
+    }
+
+    environments.pop();
+    return blockRes;
   }
 
   /*
+   * printf extern function:
    *
+   * (printf "Value: %d" 42)
+   */
+  llvm::Value* genPrintf(const Expr& expr, Env env) {
+    auto printfFn = module->getFunction("printf");
+    std::vector<llvm::Value *> args;
+
+    for (uint32_t i = 1; i < expr.size; i += 1) {
+      args.push_back(gen(ast.child(expr, i), env));
+    }
+    return builder->CreateCall(printfFn, args);
+  }
+
+  /*
+   * Initializes the host target, once per process.
+   */
+  static void initNativeTarget() {
+    static std::once_flag nativeTargetInit;
+    std::call_once(nativeTargetInit, []() {
+      llvm::InitializeNativeTarget();
+      llvm::InitializeNativeTargetAsmPrinter();
+    });
+  }
+
+  /*
+   * Creates the target machine for the host triple, either for the host
+   * CPU and features or a generic CPU, and sets the module's triple and
+   * data layout to it.
+   */
+  void setupTargetMachine() {
+    initNativeTarget();
+
+    auto triple = llvm::sys::getDefaultTargetTriple();
+
+    std::string error;
+    auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (!target) {
+      DIE << "Cannot find the target " << triple << ": " << error;
+    }
+
+    std::string cpu = "generic";
+    std::string features;
+
+    if (nativeCpu) {
+      cpu = llvm::sys::getHostCPUName().str();
+
+      llvm::StringMap<bool> hostFeatures;
+      if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+        for (auto &feature : hostFeatures) {
+          features += (feature.getValue() ? "+" : "-") + feature.getKey().str() + ",";
+        }
+      }
+    }
+
+    targetMachine.reset(target->createTargetMachine(triple, cpu, features, llvm::TargetOptions(),
+                                                    llvm::Reloc::PIC_, /* codeModel */ {},
+                                                    getCodeGenLevel(optLevel)));
+
+    module->setTargetTriple(triple);
+    module->setDataLayout(targetMachine->createDataLayout());
+  }
+
+  /*
+   * Generates machine code for the module into an object file.
+   */
+  void emitObjectFile(const std::string &path) {
+    std::error_code errorCode;
+    llvm::raw_fd_ostream out(path, errorCode, llvm::sys::fs::OF_None);
+
+    if (errorCode) {
+      DIE << "Cannot open " << path << ": " << errorCode.message();
+    }
+
+#if LLVM_VERSION_MAJOR >= 18
+    auto fileType = llvm::CodeGenFileType::ObjectFile;
+#else
+    auto fileType = llvm::CGFT_ObjectFile;
+#endif
+
+    llvm::legacy::PassManager codegenPasses;
+    if (targetMachine->addPassesToEmitFile(codegenPasses, out, nullptr, fileType)) {
+      DIE << "The target cannot emit object files.";
+    }
+
+    codegenPasses.run(*module);
+  }
+
+  /*
+   * Links an object file into an executable with the system C compiler
+   * driver (cc), against the C library. The object file is removed.
    */
-  llvm::Type* extractVarType(const Expr& expr) {
-    return expr.type == ExprType::LIST ? getTypeFromString(expr.list[1].string) : builder->getInt32Ty();
+  void linkExecutable(const std::string &objectPath, const std::string &path) {
+    auto linker = llvm::sys::findProgramByName("cc");
+    if (!linker) {
+      DIE << "Cannot find the linker (cc): " << linker.getError().message();
+    }
+
+    std::string errorMessage;
+    auto status = llvm::sys::ExecuteAndWait(*linker, {*linker, objectPath, "-o", path},
+                                            /* env */ {}, /* redirects */ {},
+                                            /* secondsToWait */ 0, /* memoryLimit */ 0, &errorMessage);
+    llvm::sys::fs::remove(objectPath);
+
+    if (status != 0) {
+      DIE << "Linking " << path << " failed: " << errorMessage;
+    }
   }
 
-  llvm::Type* getTypeFromString(const std::string& type_) {
-    // number -> i32
-    if (type_ == "number") {
-      return builder->getInt32Ty();
+  /*
+   * Hands the module to an LLJIT instance and calls main.
+   */
+  int runMain() {
+    initNativeTarget();
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+      DIE << "Cannot create the JIT: " << llvm::toString(jit.takeError());
+    }
+
+    auto hostSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        (*jit)->getDataLayout().getGlobalPrefix());
+    if (!hostSymbols) {
+      DIE << "Cannot load host symbols: " << llvm::toString(hostSymbols.takeError());
     }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*hostSymbols));
 
-    // string -> i8* (aka char*)
-    if (type_ == "string") {
-      return builder->getInt8Ty()->getPointerTo();
+    if (auto error = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(ctx)))) {
+      DIE << "Cannot add the module to the JIT: " << llvm::toString(std::move(error));
+    }
+
+    auto mainSymbol = (*jit)->lookup("main");
+    if (!mainSymbol) {
+      DIE << "Cannot compile main: " << llvm::toString(mainSymbol.takeError());
+    }
+
+#if LLVM_VERSION_MAJOR >= 15
+    auto main = mainSymbol->toPtr<int()>();
+#else
+    auto main = (int (*)()) mainSymbol->getAddress();
+#endif
+
+    return main();
+  }
+
+  /*
+   * LLVM's code generator level.
+   */
+#if LLVM_VERSION_MAJOR >= 18
+  static llvm::CodeGenOptLevel getCodeGenLevel(OptLevel level) {
+    using CodeGenLevel = llvm::CodeGenOptLevel;
+#else
+  static llvm::CodeGenOpt::Level getCodeGenLevel(OptLevel level) {
+    using CodeGenLevel = llvm::CodeGenOpt::Level;
+#endif
+    switch (level) {
+      case OptLevel::O0:
+        return CodeGenLevel::None;
+      case OptLevel::O1:
+        return CodeGenLevel::Less;
+      case OptLevel::O3:
+        return CodeGenLevel::Aggressive;
+      default:
+        return CodeGenLevel::Default;
     }
+  }
 
-    // default
-    return builder->getInt32Ty();
+  /*
+   * LLVM's level for a default pipeline.
+   */
+  static llvm::OptimizationLevel getPassBuilderLevel(OptLevel level) {
+    switch (level) {
+      case OptLevel::O1:
+        return llvm::OptimizationLevel::O1;
+      case OptLevel::O2:
+        return llvm::OptimizationLevel::O2;
+      case OptLevel::O3:
+        return llvm::OptimizationLevel::O3;
+      case OptLevel::Os:
+        return llvm::OptimizationLevel::Os;
+      default:
+        return llvm::OptimizationLevel::O0;
+    }
   }
 
-  llvm::Value* allocVar(const std::string& name, llvm::Type* type_, Env env) {
-    varsBuilder->SetInsertPoint(&fn->getEntryBlock());
+  /*
+   * Reports all undefined variables found by the resolver, and exits.
+   */
+  void reportUndefinedVariables() {
+    auto error = DIE;
+    for (auto name : resolver.undefined()) {
+      error << "Variable \"" << symbolName(name) << "\" is not defined.\n";
+    }
+  }
 
-    auto varAlloc = varsBuilder->CreateAlloca(type_, 0, name.c_str());
+  /*
+   * Reports all type errors of a program, and exits.
+   */
+  void reportTypeErrors() {
+    auto error = DIE;
+    for (const auto& message : typeChecker->errors()) {
+      error << message << "\n";
+    }
+  }
 
-    // Add to the environment
-    env->define(name, varAlloc);
+  /*
+   * Returns the special form of a symbol, or nullptr.
+   */
+  const SpecialForm* findSpecialForm(Symbol name) const {
+    if (name < specialForms.size() && specialForms[name]) {
+      return &specialForms[name];
+    }
+    return nullptr;
+  }
 
-    return varAlloc;
+  /*
+   * Extracts variable or parameter name (its type is inferred by the
+   * TypeChecker).
+   * x -> x
+   * (x number) -> x
+   */
+  Symbol extractVarName(const Expr& expr) {
+    return expr.type == ExprType::LIST ? ast.child(expr, 0).symbol : expr.symbol;
   }
 
   /*
@@ -284,7 +865,7 @@ class Eva {
     llvm::verifyFunction(*fn);
 
     // Install in the environment.
-    env->define(fnName, fn);
+    env->define(intern(fnName), fn);
 
     return fn;
   }
@@ -295,6 +876,9 @@ class Eva {
   void createFunctionBlock(llvm::Function* fn) {
     auto entry = createBB("entry", fn);
     builder->SetInsertPoint(entry);
+
+    // The entry block has no predecessors.
+    ssa.sealBlock(entry);
   }
 
   /*
@@ -311,9 +895,27 @@ class Eva {
     std::error_code errorCode;
     llvm::raw_fd_ostream outLL(filename, errorCode);
 
+    if (errorCode) {
+      DIE << "Cannot open " << filename << ": " << errorCode.message();
+    }
+
     module->print(outLL, nullptr);
   }
 
+  /*
+   * Saves the module as bitcode.
+   */
+  void saveBitcodeToFile(const std::string &filename) {
+    std::error_code errorCode;
+    llvm::raw_fd_ostream outBC(filename, errorCode, llvm::sys::fs::OF_None);
+
+    if (errorCode) {
+      DIE << "Cannot open " << filename << ": " << errorCode.message();
+    }
+
+    llvm::WriteBitcodeToFile(*module, outBC);
+  }
+
   /*
    * Initialise the module.
    */
@@ -325,8 +927,21 @@ class Eva {
     // Create a builder for the module.
     builder = std::make_unique<llvm::IRBuilder<>>(*ctx);
 
-    // Vars builder
-    varsBuilder = std::make_unique<llvm::IRBuilder<>>(*ctx);
+    // String constants of the module.
+    strings = std::make_unique<StringPool>(*module, mergeStrings);
+
+    // Static types of the expressions.
+    typeChecker = std::make_unique<TypeChecker>(*ctx, [this](Symbol name) { return findSpecialForm(name) != nullptr; });
+  }
+
+  /*
+   * Sets up the built-in special forms.
+   */
+  void setupSpecialForms() {
+    defineSpecialForm("var", [this](const Expr& expr, Env env) { return genVar(expr, env); });
+    defineSpecialForm("set", [this](const Expr& expr, Env env) { return genSet(expr, env); });
+    defineSpecialForm("begin", [this](const Expr& expr, Env env) { return genBegin(expr, env); });
+    defineSpecialForm("printf", [this](const Expr& expr, Env env) { return genPrintf(expr, env); });
   }
 
   /*
@@ -337,20 +952,48 @@ class Eva {
       {"VERSION", builder->getInt32(42)},
     };
 
-    std::map<std::string, llvm::Value*> globalRec{};
+    GlobalEnv = environments.global();
 
     for (auto &entry: globalObject) {
-      globalRec[entry.first] = createGlobalVar(entry.first, (llvm::Constant*) entry.second);
+      GlobalEnv->define(intern(entry.first), createGlobalVar(entry.first, (llvm::Constant*) entry.second));
     }
-
-    GlobalEnv = std::make_shared<Environment>(globalRec, nullptr);
   }
 
+  // Environments of the enclosing blocks.
+  EnvironmentStack environments;
+
   // Global Environment (symbol table)
-  std::shared_ptr<Environment> GlobalEnv;
+  Env GlobalEnv;
 
   // Parser
-  std::unique_ptr<EvaParser> parser;
+  std::unique_ptr<ProgramParser> parser;
+
+  // Compile top-level forms as they are parsed.
+  bool streaming;
+
+  // Optimization level.
+  OptLevel optLevel;
+
+  // Generate code for the host CPU.
+  bool nativeCpu;
+
+  // Merge string constants by suffix.
+  bool mergeStrings;
+
+  // Host target, for native code generation.
+  std::unique_ptr<llvm::TargetMachine> targetMachine;
+
+  // Special forms, indexed by symbol.
+  std::vector<SpecialForm> specialForms;
+
+  // Lexical addresses of the variables being compiled.
+  Resolver resolver;
+
+  // Parsed AST cache, if enabled.
+  std::unique_ptr<AstCache> astCache;
+
+  // Currently compiling AST.
+  AstView ast;
 
   // Currently compiling function.
   llvm::Function* fn;
@@ -364,9 +1007,14 @@ class Eva {
   // LLVM IR Builder
   std::unique_ptr<llvm::IRBuilder<>> builder;
 
-  // Extra builder for variable declarations. This builder prepends
-  // to the beginning of every function block.
-  std::unique_ptr<llvm::IRBuilder<>> varsBuilder;
+  // SSA values of the local variables.
+  SsaBuilder ssa;
+
+  // String constants of the module.
+  std::unique_ptr<StringPool> strings;
+
+  // Static types of the expressions.
+  std::unique_ptr<TypeChecker> typeChecker;
 };
 
 #endif //EVA_EVA_H
@@ -0,0 +1,229 @@
+/*
+ * Resolver: lexical addressing of variables.
+ */
+
+#ifndef EVA_RESOLVER_H
+#define EVA_RESOLVER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Ast.h"
+#include "Environment.h"
+#include "SymbolMap.h"
+
+/*
+ * Lexical address of a variable: the number of scopes up from the
+ * reference, and the slot of the binding in that scope. A dynamic address
+ * is looked up by name in the environments when compiled.
+ */
+struct VarAddress {
+  static constexpr uint32_t DYNAMIC = UINT32_MAX;
+
+  uint32_t depth;
+  uint32_t slot;
+
+  bool isDynamic() const {
+    return depth == DYNAMIC;
+  }
+};
+
+/*
+ * Static pass run between parsing and codegen. It follows the scoping of
+ * the special forms, where `begin` opens a scope and `var` defines a
+ * variable in it after its initializer. It assigns each binding a slot,
+ * and gives each variable reference (including the target of `set`) its
+ * address. Undefined variables are collected for the whole program.
+ *
+ * Other forms and calls are resolved as if their arguments were
+ * expressions in the enclosing scope. Forms other than the built-in ones
+ * may define variables while compiled, which shifts the slots of the
+ * bindings after them: from such a form to the end of the outermost
+ * scope, references get dynamic addresses, and names that are not found
+ * are left to the lookup in codegen.
+ */
+class Resolver {
+ public:
+
+  explicit Resolver(std::function<bool(Symbol)> isSpecialForm)
+      : isSpecialForm_(std::move(isSpecialForm)) {}
+
+  /*
+   * Resolves an AST in the current scope, with the given global
+   * environment outside of all scopes. Returns false if some variables
+   * are not defined (see `undefined`).
+   */
+  bool resolve(AstView ast, const Environment& globals) {
+    ast_ = ast;
+    globals_ = &globals;
+
+    if (openScopes_ == 0) {
+      dynamic_ = false;
+    }
+
+    addresses_.assign(ast.size(), {});
+    undefined_.clear();
+
+    resolve_(ast.root());
+
+    return undefined_.empty();
+  }
+
+  /*
+   * Opens and closes a scope, for scopes that span several `resolve` calls.
+   * Closed scopes are kept and reused with their storage.
+   */
+  void beginScope() {
+    if (openScopes_ == 0) {
+      dynamic_ = false;
+    }
+
+    if (openScopes_ == scopes_.size()) {
+      scopes_.emplace_back();
+    } else {
+      scopes_[openScopes_].slots.clear();
+      scopes_[openScopes_].size = 0;
+    }
+    openScopes_++;
+  }
+
+  void endScope() {
+    openScopes_--;
+  }
+
+  /*
+   * Address of a variable reference.
+   */
+  VarAddress address(NodeId id) const {
+    return addresses_[id];
+  }
+
+  /*
+   * Undefined variables of the last resolved AST, once each, in order of
+   * first use.
+   */
+  const std::vector<Symbol>& undefined() const {
+    return undefined_;
+  }
+
+ private:
+
+  /*
+   * Scope: slots of the bindings defined so far.
+   */
+  struct Scope {
+    SymbolMap<uint32_t> slots;
+    uint32_t size = 0;
+  };
+
+  void resolve_(const Expr& expr) {
+    if (expr.type == ExprType::SYMBOL) {
+      reference_(expr);
+      return;
+    }
+
+    if (expr.type != ExprType::LIST || expr.size == 0) {
+      return;
+    }
+
+    const auto& tag = ast_.child(expr, 0);
+    auto isForm = tag.type == ExprType::SYMBOL && isSpecialForm_(tag.symbol);
+    auto op = isForm ? tag.symbol : WELL_KNOWN_SYMBOLS_COUNT;
+
+    // (var <name> <init>), (var (<name> <type>) <init>)
+    if (op == SYM_VAR) {
+      resolve_(ast_.child(expr, 2));
+
+      const auto& decl = ast_.child(expr, 1);
+      define_(decl.type == ExprType::LIST ? ast_.child(decl, 0).symbol : decl.symbol);
+    }
+
+    // (set <name> <value>)
+    else if (op == SYM_SET) {
+      resolve_(ast_.child(expr, 2));
+      reference_(ast_.child(expr, 1));
+    }
+
+    // (begin <expressions>)
+    else if (op == SYM_BEGIN) {
+      beginScope();
+      for (uint32_t i = 1; i < expr.size; i++) {
+        resolve_(ast_.child(expr, i));
+      }
+      endScope();
+    }
+
+    // Other forms: (<form> <expressions>), calls: (<expressions>)
+    else {
+      if (isForm && op != SYM_PRINTF) {
+        dynamic_ = true;
+      }
+      for (uint32_t i = isForm ? 1 : 0; i < expr.size; i++) {
+        resolve_(ast_.child(expr, i));
+      }
+    }
+  }
+
+  void define_(Symbol name) {
+    auto& scope = scopes_[openScopes_ - 1];
+    scope.slots.set(name, scope.size++);
+  }
+
+  void reference_(const Expr& expr) {
+    auto name = expr.symbol;
+
+    if (name == SYM_TRUE || name == SYM_FALSE) {
+      return;
+    }
+
+    auto& address = addresses_[ast_.idOf(expr)];
+
+    if (dynamic_) {
+      address = {VarAddress::DYNAMIC, 0};
+      return;
+    }
+
+    for (uint32_t depth = 0; depth < openScopes_; depth++) {
+      if (auto slot = scopes_[openScopes_ - 1 - depth].slots.find(name)) {
+        address = {depth, *slot};
+        return;
+      }
+    }
+
+    if (auto slot = globals_->slotOf(name)) {
+      address = {openScopes_, *slot};
+      return;
+    }
+
+    if (std::find(undefined_.begin(), undefined_.end(), name) == undefined_.end()) {
+      undefined_.push_back(name);
+    }
+  }
+
+  // Whether a symbol names a special form.
+  std::function<bool(Symbol)> isSpecialForm_;
+
+  // AST being resolved.
+  AstView ast_;
+
+  // Global environment, outside of all scopes.
+  const Environment* globals_ = nullptr;
+
+  // Scopes, innermost last; the first `openScopes_` are open.
+  std::vector<Scope> scopes_;
+  uint32_t openScopes_ = 0;
+
+  // Whether a form that may define variables was met in the outermost
+  // scope: references are then dynamic.
+  bool dynamic_ = false;
+
+  // Addresses of the variable references, by node.
+  std::vector<VarAddress> addresses_;
+
+  // Undefined variables.
+  std::vector<Symbol> undefined_;
+};
+
+#endif //EVA_RESOLVER_H
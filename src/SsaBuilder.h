@@ -0,0 +1,196 @@
+/*
+ * SSA construction for local variables.
+ */
+
+#ifndef EVA_SSABUILDER_H
+#define EVA_SSABUILDER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/ValueHandle.h>
+
+#include "SymbolTable.h"
+
+/*
+ * Builds SSA values for local variables while their code is generated,
+ * without allocas, loads and stores (Braun et al., "Simple and Efficient
+ * Construction of Static Single Assignment Form", 2013).
+ *
+ * Codegen records each assignment of a variable in the current block
+ * (`write`), and asks for its value where it is used (`read`). A value
+ * not defined in a block is looked up in its predecessors, with a phi
+ * where several of them join. Blocks are sealed once all of their
+ * predecessors are known; reads in an unsealed block (a loop header)
+ * get a placeholder phi, completed when it is sealed. Phis that turn out
+ * to merge a single value are removed.
+ */
+class SsaBuilder {
+ public:
+
+  /*
+   * Declares a variable of a type, and returns its number.
+   */
+  uint32_t addVariable(Symbol name, llvm::Type* type) {
+    variables_.push_back({name, type});
+    return variables_.size() - 1;
+  }
+
+  /*
+   * Sets the value of a variable at the end of a block.
+   */
+  void write(uint32_t variable, llvm::BasicBlock* block, llvm::Value* value) {
+    definitions_[{variable, block}] = value;
+  }
+
+  /*
+   * Returns the value of a variable at the end of a block.
+   */
+  llvm::Value* read(uint32_t variable, llvm::BasicBlock* block) {
+    auto definition = definitions_.find({variable, block});
+
+    if (definition != definitions_.end() && definition->second) {
+      return definition->second;
+    }
+    return readRecursive_(variable, block);
+  }
+
+  /*
+   * Marks a block whose predecessors are all known, and completes the
+   * phis placed in it while it was not.
+   */
+  void sealBlock(llvm::BasicBlock* block) {
+    if (auto incomplete = incompletePhis_.find(block); incomplete != incompletePhis_.end()) {
+      auto phis = std::move(incomplete->second);
+      incompletePhis_.erase(incomplete);
+
+      for (auto [variable, phi] : phis) {
+        addPhiOperands_(variable, phi);
+      }
+    }
+    sealed_.insert(block);
+  }
+
+ private:
+
+  struct Variable {
+    Symbol name;
+    llvm::Type* type;
+  };
+
+  llvm::Value* readRecursive_(uint32_t variable, llvm::BasicBlock* block) {
+    llvm::Value* value;
+
+    // Not all predecessors known yet: completed on sealing.
+    if (!sealed_.contains(block)) {
+      auto phi = createPhi_(variable, block);
+      incompletePhis_[block].emplace_back(variable, phi);
+      value = phi;
+    }
+
+    // One predecessor: no phi needed.
+    else if (auto predecessor = block->getSinglePredecessor()) {
+      value = read(variable, predecessor);
+    }
+
+    // Entry block: read before any write.
+    else if (llvm::pred_empty(block)) {
+      value = llvm::UndefValue::get(variables_[variable].type);
+    }
+
+    // Join: the phi is written first, to break cycles through loops.
+    else {
+      auto phi = createPhi_(variable, block);
+      write(variable, block, phi);
+      value = addPhiOperands_(variable, phi);
+    }
+
+    write(variable, block, value);
+    return value;
+  }
+
+  llvm::PHINode* createPhi_(uint32_t variable, llvm::BasicBlock* block) {
+    const auto& [name, type] = variables_[variable];
+
+    if (auto first = block->getFirstNonPHI()) {
+      return llvm::PHINode::Create(type, 2, symbolName(name), first);
+    }
+    return llvm::PHINode::Create(type, 2, symbolName(name), block);
+  }
+
+  llvm::Value* addPhiOperands_(uint32_t variable, llvm::PHINode* phi) {
+    // One incoming value per edge, so a predecessor may repeat.
+    for (auto predecessor : llvm::predecessors(phi->getParent())) {
+      phi->addIncoming(read(variable, predecessor), predecessor);
+    }
+    return tryRemoveTrivialPhi_(phi);
+  }
+
+  /*
+   * Replaces a phi that merges only one value (and itself) by that value,
+   * then retries the phis that used it.
+   */
+  llvm::Value* tryRemoveTrivialPhi_(llvm::PHINode* phi) {
+    llvm::Value* same = nullptr;
+
+    for (auto& operand : phi->incoming_values()) {
+      if (operand == same || operand == phi) {
+        continue;
+      }
+      if (same) {
+        return phi;
+      }
+      same = operand;
+    }
+
+    if (!same) {
+      same = llvm::UndefValue::get(phi->getType());
+    }
+
+    llvm::SmallVector<llvm::WeakTrackingVH, 4> phiUsers;
+    for (auto user : phi->users()) {
+      if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+        phiUsers.emplace_back(user);
+      }
+    }
+
+    // Definitions are value handles, so they follow the replacement.
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+
+    // Only complete phis: placeholders and phis being filled are checked
+    // once they have all of their operands.
+    for (auto& user : phiUsers) {
+      auto userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(user);
+
+      if (userPhi && sealed_.contains(userPhi->getParent()) &&
+          userPhi->getNumIncomingValues() == llvm::pred_size(userPhi->getParent())) {
+        tryRemoveTrivialPhi_(userPhi);
+      }
+    }
+
+    return same;
+  }
+
+  // Declared variables, by number.
+  std::vector<Variable> variables_;
+
+  // Value of each variable at the end of the blocks that define it.
+  llvm::DenseMap<std::pair<uint32_t, llvm::BasicBlock*>, llvm::WeakTrackingVH> definitions_;
+
+  // Blocks with all predecessors known.
+  llvm::SmallPtrSet<llvm::BasicBlock*, 16> sealed_;
+
+  // Placeholder phis of unsealed blocks.
+  llvm::DenseMap<llvm::BasicBlock*, std::vector<std::pair<uint32_t, llvm::PHINode*>>> incompletePhis_;
+};
+
+#endif //EVA_SSABUILDER_H
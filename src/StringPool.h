@@ -0,0 +1,142 @@
+/*
+ * Pool of the string constants of a module.
+ */
+
+#ifndef EVA_STRINGPOOL_H
+#define EVA_STRINGPOOL_H
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Module.h>
+
+/*
+ * Interns string literals by their contents: each distinct string is one
+ * private `unnamed_addr` constant of the module, created on first use, and
+ * every literal with the same contents points to it.
+ *
+ * With suffix merging, `finish` also folds each string that is a suffix
+ * of another one into it ("%d\n" into "X: %d\n"), pointing its uses into
+ * the longer constant.
+ */
+class StringPool {
+ public:
+
+  explicit StringPool(llvm::Module& module, bool mergeSuffixes = false)
+      : module_(module), mergeSuffixes_(mergeSuffixes) {}
+
+  /*
+   * Returns a pointer to the first character of the (NUL-terminated)
+   * constant of a string.
+   */
+  llvm::Constant* get(std::string_view contents) {
+    auto [entry, inserted] = strings_.try_emplace(llvm::StringRef(contents.data(), contents.size()));
+
+    if (inserted) {
+      entry->second = create_(entry->getKey());
+    }
+    return entry->second.pointer;
+  }
+
+  /*
+   * Number of distinct strings in the pool.
+   */
+  size_t size() const {
+    return strings_.size();
+  }
+
+  /*
+   * Ends a module's strings: merges the suffixes if enabled. The pool is
+   * emptied, so later literals get new constants.
+   */
+  void finish() {
+    if (mergeSuffixes_) {
+      merge_();
+    }
+    strings_.clear();
+  }
+
+ private:
+
+  /*
+   * Pooled string: its constant, and the pointer to its first character.
+   */
+  struct Entry {
+    llvm::GlobalVariable* global = nullptr;
+    llvm::Constant* pointer = nullptr;
+  };
+
+  Entry create_(llvm::StringRef contents) {
+    auto& ctx = module_.getContext();
+    auto data = llvm::ConstantDataArray::getString(ctx, contents);
+
+    auto global = new llvm::GlobalVariable(module_, data->getType(), /* isConstant */ true,
+                                           llvm::GlobalValue::PrivateLinkage, data);
+    global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    global->setAlignment(llvm::Align(1));
+
+    return {global, pointerInto_(global, 0)};
+  }
+
+  static llvm::Constant* pointerInto_(llvm::GlobalVariable* global, uint32_t offset) {
+    auto& ctx = global->getContext();
+    auto indexType = llvm::Type::getInt32Ty(ctx);
+
+    llvm::Constant* indices[] = {llvm::ConstantInt::get(indexType, 0), llvm::ConstantInt::get(indexType, offset)};
+
+    return llvm::ConstantExpr::getInBoundsGetElementPtr(global->getValueType(), global, indices);
+  }
+
+  /*
+   * Sorted by their reversed contents, a string that is a suffix of others
+   * comes right before the first of them. Walking back from the end, each
+   * string is a suffix of the one after it or starts a new group, whose
+   * longest string holds the whole group.
+   */
+  void merge_() {
+    std::vector<llvm::StringMapEntry<Entry>*> entries;
+    entries.reserve(strings_.size());
+
+    for (auto& entry : strings_) {
+      entries.push_back(&entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](auto a, auto b) {
+      std::string_view x = a->getKey(), y = b->getKey();
+      return std::lexicographical_compare(x.rbegin(), x.rend(), y.rbegin(), y.rend());
+    });
+
+    llvm::StringMapEntry<Entry>* previous = nullptr;
+    llvm::StringMapEntry<Entry>* longest = nullptr;
+
+    for (auto it = entries.rbegin(); it != entries.rend(); it++) {
+      auto entry = *it;
+
+      if (previous && std::string_view(previous->getKey()).ends_with(std::string_view(entry->getKey()))) {
+        auto global = entry->second.global;
+        auto offset = longest->getKey().size() - entry->getKey().size();
+        auto pointer = pointerInto_(longest->second.global, offset);
+
+        global->replaceAllUsesWith(llvm::ConstantExpr::getPointerCast(pointer, global->getType()));
+        global->eraseFromParent();
+      } else {
+        longest = entry;
+      }
+      previous = entry;
+    }
+  }
+
+  llvm::Module& module_;
+
+  bool mergeSuffixes_;
+
+  // Pooled strings, by contents.
+  llvm::StringMap<Entry> strings_;
+};
+
+#endif //EVA_STRINGPOOL_H
@@ -0,0 +1,159 @@
+/*
+ * Flat hash map keyed by symbol.
+ */
+
+#ifndef EVA_SYMBOLMAP_H
+#define EVA_SYMBOLMAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+#include "SymbolTable.h"
+
+/*
+ * Open-addressing hash map from symbols to values, with linear probing
+ * in one flat array of slots. Symbols are dense integers, so a
+ * multiplicative hash spreads them well and a lookup is usually one
+ * probe. Entries are never erased.
+ */
+template <typename V>
+class SymbolMap {
+ public:
+
+  SymbolMap() = default;
+
+  SymbolMap(std::initializer_list<std::pair<Symbol, V>> entries) {
+    for (const auto& [key, value] : entries) {
+      set(key, value);
+    }
+  }
+
+  SymbolMap(SymbolMap&&) noexcept = default;
+  SymbolMap& operator=(SymbolMap&&) noexcept = default;
+
+  /*
+   * Returns the value of a key, or nullptr.
+   */
+  V* find(Symbol key) const {
+    if (capacity_ == 0) {
+      return nullptr;
+    }
+
+    for (auto i = slotOf_(key);; i = (i + 1) & (capacity_ - 1)) {
+      auto& slot = slots_[i];
+
+      if (slot.key == key) {
+        return &slot.value;
+      }
+      if (slot.key == EMPTY_) {
+        return nullptr;
+      }
+    }
+  }
+
+  bool contains(Symbol key) const {
+    return find(key) != nullptr;
+  }
+
+  /*
+   * Sets the value of a key, inserting it if needed.
+   */
+  V& set(Symbol key, V value) {
+    if ((size_ + 1) * 4 > capacity_ * 3) {
+      grow_();
+    }
+
+    auto& slot = probe_(key);
+
+    if (slot.key == EMPTY_) {
+      slot.key = key;
+      size_++;
+    }
+    slot.value = std::move(value);
+
+    return slot.value;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  /*
+   * Removes all entries. Small tables keep their slots for reuse.
+   */
+  void clear() {
+    if (capacity_ > MAX_REUSED_CAPACITY_) {
+      slots_.reset();
+      capacity_ = 0;
+      shift_ = 64;
+    } else if (size_ > 0) {
+      std::fill_n(slots_.get(), capacity_, Slot{});
+    }
+    size_ = 0;
+  }
+
+ private:
+
+  static constexpr Symbol EMPTY_ = ~Symbol(0);
+
+  static constexpr size_t MIN_CAPACITY_ = 8;
+
+  static constexpr size_t MAX_REUSED_CAPACITY_ = 64;
+
+  struct Slot {
+    Symbol key = EMPTY_;
+    V value{};
+  };
+
+  /*
+   * Fibonacci hashing: the top bits of key * 2^64/phi.
+   */
+  size_t slotOf_(Symbol key) const {
+    return (size_t) ((key * 0x9E3779B97F4A7C15ull) >> shift_);
+  }
+
+  /*
+   * Returns the slot of a key, or the empty slot it would go in.
+   */
+  Slot& probe_(Symbol key) const {
+    auto i = slotOf_(key);
+
+    while (slots_[i].key != key && slots_[i].key != EMPTY_) {
+      i = (i + 1) & (capacity_ - 1);
+    }
+    return slots_[i];
+  }
+
+  void grow_() {
+    auto oldSlots = std::move(slots_);
+    auto oldCapacity = capacity_;
+
+    capacity_ = capacity_ == 0 ? MIN_CAPACITY_ : capacity_ * 2;
+    shift_ = 64 - std::countr_zero(capacity_);
+    slots_ = std::make_unique<Slot[]>(capacity_);
+
+    for (size_t i = 0; i < oldCapacity; i++) {
+      if (oldSlots[i].key != EMPTY_) {
+        auto& slot = probe_(oldSlots[i].key);
+        slot.key = oldSlots[i].key;
+        slot.value = std::move(oldSlots[i].value);
+      }
+    }
+  }
+
+  // Slots; capacity is a power of two.
+  std::unique_ptr<Slot[]> slots_;
+
+  size_t capacity_ = 0;
+
+  // 64 - log2(capacity)
+  int shift_ = 64;
+
+  size_t size_ = 0;
+};
+
+#endif //EVA_SYMBOLMAP_H
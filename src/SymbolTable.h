@@ -0,0 +1,139 @@
+/*
+ * Symbol table: interned symbol names.
+ */
+
+#ifndef EVA_SYMBOLTABLE_H
+#define EVA_SYMBOLTABLE_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+ * Symbol: 32-bit ID of an interned name. Identical names share one ID,
+ * so symbols are compared and hashed as integers.
+ */
+using Symbol = uint32_t;
+
+/*
+ * Well-known symbols, interned first so their IDs are constants.
+ */
+enum WellKnownSymbol : Symbol {
+  SYM_VAR,
+  SYM_SET,
+  SYM_BEGIN,
+  SYM_PRINTF,
+  SYM_TRUE,
+  SYM_FALSE,
+  SYM_NUMBER,
+  SYM_STRING,
+  WELL_KNOWN_SYMBOLS_COUNT
+};
+
+class SymbolTable {
+ public:
+
+  SymbolTable() {
+    static constexpr std::array<std::string_view, WELL_KNOWN_SYMBOLS_COUNT> wellKnown {
+      "var", "set", "begin", "printf", "true", "false", "number", "string",
+    };
+
+    for (auto name: wellKnown) {
+      intern(name);
+    }
+  }
+
+  /*
+   * Returns the symbol for a name, interning it on first use.
+   * Safe to call from several parser threads.
+   */
+  Symbol intern(std::string_view name) {
+    {
+      std::shared_lock lock(mutex_);
+
+      auto it = ids_.find(name);
+      if (it != ids_.end()) {
+        return it->second;
+      }
+    }
+
+    std::unique_lock lock(mutex_);
+
+    // Another thread may have interned it in between.
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+
+    // Names are stored in a deque, so views into them stay valid.
+    auto symbol = (Symbol) names_.size();
+    const auto& stored = names_.emplace_back(name);
+    ids_.emplace(stored, symbol);
+
+    return symbol;
+  }
+
+  /*
+   * Returns the name of a symbol.
+   */
+  std::string_view name(Symbol symbol) const {
+    std::shared_lock lock(mutex_);
+    return names_[symbol];
+  }
+
+  /*
+   * Number of interned symbols.
+   */
+  size_t size() const {
+    std::shared_lock lock(mutex_);
+    return names_.size();
+  }
+
+ private:
+
+  // Guards interning from parser threads.
+  mutable std::shared_mutex mutex_;
+
+  // Symbol names, indexed by ID.
+  std::deque<std::string> names_;
+
+  // Name -> ID
+  std::unordered_map<std::string_view, Symbol> ids_;
+};
+
+/*
+ * Global symbol table shared by the lexer, the AST and the environments.
+ */
+inline SymbolTable& symbolTable() {
+  static SymbolTable table;
+  return table;
+}
+
+/*
+ * Interns a name in the global table. Each thread keeps the names it has
+ * interned in a cache of its own, keyed by the table's copies, so repeated
+ * names (most tokens) take no lock; the table is locked on a miss only.
+ */
+inline Symbol intern(std::string_view name) {
+  thread_local std::unordered_map<std::string_view, Symbol> cache;
+
+  if (auto it = cache.find(name); it != cache.end()) {
+    return it->second;
+  }
+
+  auto symbol = symbolTable().intern(name);
+  cache.emplace(symbolTable().name(symbol), symbol);
+
+  return symbol;
+}
+
+inline std::string_view symbolName(Symbol symbol) {
+  return symbolTable().name(symbol);
+}
+
+#endif //EVA_SYMBOLTABLE_H
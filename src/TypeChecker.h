@@ -0,0 +1,309 @@
+/*
+ * TypeChecker: static types of expressions.
+ */
+
+#ifndef EVA_TYPECHECKER_H
+#define EVA_TYPECHECKER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Type.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "Ast.h"
+#include "Environment.h"
+#include "Resolver.h"
+
+/*
+ * Static pass run after the Resolver and before codegen. It infers the
+ * LLVM type of every expression, and checks that the values of variables
+ * and the arguments of the forms have the expected types:
+ *
+ *   42: i32 (number), "str": i8* (string), true/false: i1 (boolean)
+ *   (var <name> <init>): the variable has the type of <init>
+ *   (var (<name> <type>) <init>): <type>, and <init> must be one
+ *   (set <name> <value>): the type of the variable, and <value> must be one
+ *   (begin <expressions>): the type of the last expression, void if empty
+ *   (printf <format> <args>): i32, and <format> must be a string
+ *
+ * An empty block has no value, so it cannot initialize or set a variable,
+ * nor be an argument of printf; an empty list is an error. Bindings follow the scopes of the Resolver,
+ * and references are typed through their lexical addresses; dynamic ones,
+ * other forms and calls have no static type (null). Type errors are
+ * collected for the whole program.
+ */
+class TypeChecker {
+ public:
+
+  TypeChecker(llvm::LLVMContext& ctx, std::function<bool(Symbol)> isSpecialForm)
+      : isSpecialForm_(std::move(isSpecialForm)),
+        numberType_(llvm::Type::getInt32Ty(ctx)),
+        stringType_(llvm::Type::getInt8Ty(ctx)->getPointerTo()),
+        booleanType_(llvm::Type::getInt1Ty(ctx)),
+        voidType_(llvm::Type::getVoidTy(ctx)) {}
+
+  /*
+   * Types a resolved AST in the current scope, with the given global
+   * environment outside of all scopes. Returns false on type errors (see
+   * `errors`).
+   */
+  bool check(AstView ast, const Resolver& resolver, const Environment& globals) {
+    ast_ = ast;
+    resolver_ = &resolver;
+    globals_ = &globals;
+
+    types_.assign(ast.size(), nullptr);
+    errors_.clear();
+
+    check_(ast.root());
+
+    return errors_.empty();
+  }
+
+  /*
+   * Opens and closes a scope, for scopes that span several `check` calls.
+   */
+  void beginScope() {
+    scopeStarts_.push_back(bindings_.size());
+  }
+
+  void endScope() {
+    bindings_.resize(scopeStarts_.back());
+    scopeStarts_.pop_back();
+  }
+
+  /*
+   * Type of an expression, or null if it has no static type. The type of
+   * a variable declaration (and of its name) is the variable's type.
+   */
+  llvm::Type* typeOf(NodeId id) const {
+    return types_[id];
+  }
+
+  /*
+   * Type errors of the last checked AST, in program order.
+   */
+  const std::vector<std::string>& errors() const {
+    return errors_;
+  }
+
+ private:
+
+  llvm::Type* check_(const Expr& expr) {
+    auto& type = types_[ast_.idOf(expr)];
+
+    switch (expr.type) {
+      case ExprType::NUMBER:
+        return type = numberType_;
+
+      case ExprType::STRING:
+        return type = stringType_;
+
+      case ExprType::SYMBOL:
+        return type = reference_(expr);
+
+      case ExprType::LIST:
+        return type = checkList_(expr);
+    }
+
+    return nullptr;
+  }
+
+  llvm::Type* checkList_(const Expr& expr) {
+    // (): neither a form nor a call.
+    if (expr.size == 0) {
+      errors_.push_back("An empty list is not an expression.");
+      return nullptr;
+    }
+
+    const auto& tag = ast_.child(expr, 0);
+    auto isForm = tag.type == ExprType::SYMBOL && isSpecialForm_(tag.symbol);
+    auto op = isForm ? tag.symbol : WELL_KNOWN_SYMBOLS_COUNT;
+
+    // (var <name> <init>), (var (<name> <type>) <init>)
+    if (op == SYM_VAR) {
+      auto initType = checkValue_(ast_.child(expr, 2));
+
+      const auto& decl = ast_.child(expr, 1);
+      const auto& name = decl.type == ExprType::LIST ? ast_.child(decl, 0) : decl;
+      auto type = initType;
+
+      if (decl.type == ExprType::LIST) {
+        type = typeFromName_(ast_.child(decl, 1).symbol);
+        expect_(initType, type, "Variable \"" + std::string(symbolName(name.symbol)) + "\"");
+      }
+
+      types_[ast_.idOf(decl)] = type;
+      types_[ast_.idOf(name)] = type;
+      bindings_.push_back(type);
+
+      return type;
+    }
+
+    // (set <name> <value>)
+    if (op == SYM_SET) {
+      auto valueType = checkValue_(ast_.child(expr, 2));
+      const auto& name = ast_.child(expr, 1);
+      auto type = check_(name);
+
+      expect_(valueType, type, "Variable \"" + std::string(symbolName(name.symbol)) + "\"");
+      return type;
+    }
+
+    // (begin <expressions>)
+    if (op == SYM_BEGIN) {
+      auto type = voidType_;
+
+      beginScope();
+      for (uint32_t i = 1; i < expr.size; i++) {
+        type = check_(ast_.child(expr, i));
+      }
+      endScope();
+
+      return type;
+    }
+
+    // (printf <format> <args>)
+    if (op == SYM_PRINTF) {
+      for (uint32_t i = 1; i < expr.size; i++) {
+        auto type = checkValue_(ast_.child(expr, i));
+
+        if (i == 1) {
+          expect_(type, stringType_, "The format of printf");
+        }
+      }
+      if (expr.size < 2) {
+        errors_.push_back("printf expects a format string.");
+      }
+      return numberType_;
+    }
+
+    // Other forms: (<form> <expressions>), calls: (<expressions>)
+    for (uint32_t i = isForm ? 1 : 0; i < expr.size; i++) {
+      check_(ast_.child(expr, i));
+    }
+    return nullptr;
+  }
+
+  /*
+   * Type of an expression whose value is used.
+   */
+  llvm::Type* checkValue_(const Expr& expr) {
+    auto type = check_(expr);
+
+    if (type == voidType_) {
+      errors_.push_back("An empty begin has no value.");
+      return nullptr;
+    }
+    return type;
+  }
+
+  /*
+   * Type of a variable, by its lexical address.
+   */
+  llvm::Type* reference_(const Expr& expr) {
+    if (expr.symbol == SYM_TRUE || expr.symbol == SYM_FALSE) {
+      return booleanType_;
+    }
+
+    auto address = resolver_->address(ast_.idOf(expr));
+
+    // Possibly defined by a form while compiled.
+    if (address.isDynamic()) {
+      return nullptr;
+    }
+
+    if (address.depth < scopeStarts_.size()) {
+      return bindings_[scopeStarts_[scopeStarts_.size() - 1 - address.depth] + address.slot];
+    }
+
+    auto value = globals_->lookup(0, address.slot).value;
+
+    if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(value)) {
+      return globalVar->getValueType();
+    }
+
+    // Functions, such as `main`, are not values.
+    errors_.push_back("\"" + std::string(symbolName(expr.symbol)) + "\" is not a variable.");
+    return nullptr;
+  }
+
+  /*
+   * Type of a type name: number, string.
+   */
+  llvm::Type* typeFromName_(Symbol name) {
+    if (name == SYM_NUMBER) {
+      return numberType_;
+    }
+    if (name == SYM_STRING) {
+      return stringType_;
+    }
+
+    errors_.push_back("Unknown type \"" + std::string(symbolName(name)) + "\".");
+    return nullptr;
+  }
+
+  /*
+   * Records an error if a value's type is not the expected one. Values
+   * or expectations without a static type are not checked.
+   */
+  void expect_(llvm::Type* type, llvm::Type* expected, const std::string& what) {
+    if (type && expected && type != expected) {
+      errors_.push_back(what + " expects a " + typeName_(expected) + ", but got a " + typeName_(type) + ".");
+    }
+  }
+
+  std::string typeName_(llvm::Type* type) const {
+    if (type == numberType_) {
+      return "number";
+    }
+    if (type == stringType_) {
+      return "string";
+    }
+    if (type == booleanType_) {
+      return "boolean";
+    }
+
+    std::string name;
+    llvm::raw_string_ostream out(name);
+    type->print(out);
+    return out.str();
+  }
+
+  // Whether a symbol names a special form.
+  std::function<bool(Symbol)> isSpecialForm_;
+
+  // Types of the values.
+  llvm::Type* numberType_;
+  llvm::Type* stringType_;
+  llvm::Type* booleanType_;
+
+  // Type of empty blocks.
+  llvm::Type* voidType_;
+
+  // AST being checked, and its variable addresses.
+  AstView ast_;
+  const Resolver* resolver_ = nullptr;
+
+  // Global environment, outside of all scopes.
+  const Environment* globals_ = nullptr;
+
+  // Types of the bindings of the open scopes, innermost last, and the
+  // start of each scope in them (bindings are found at start + slot).
+  std::vector<llvm::Type*> bindings_;
+  std::vector<uint32_t> scopeStarts_;
+
+  // Types of the expressions, by node.
+  std::vector<llvm::Type*> types_;
+
+  // Type errors.
+  std::vector<std::string> errors_;
+};
+
+#endif //EVA_TYPECHECKER_H
@@ -21,15 +21,23 @@
 #pragma clang diagnostic ignored "-Wunused-private-field"
 
 #include <assert.h>
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "SimdScan.h"
+
 // ------------------------------------
 // Module include prologue.
 //
@@ -50,45 +58,117 @@
 //   }
 //
 // clang-format off
+#include <charconv>
+#include <cstdint>
 #include <string>
-#include <vector>
+#include <string_view>
 
-// Expression Type
-enum class ExprType {
-  NUMBER,
-  STRING,
-  SYMBOL,
-  LIST
-};
+#include "../Ast.h"
 
-// Expression
-struct Expr {
-  ExprType type;
+// Parses a NUMBER token. Returns false if it is out of range.
+inline bool parseNumber(std::string_view str, int& number) {
+  auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), number);
+  return error == std::errc();
+}
 
-  int number;
-  std::string string;
-  std::vector<Expr> list;
+// Decodes the escape sequences of a STRING token's contents in one pass:
+// \n \t \r \0 \\ \" \xNN (a byte), and \u{N...} (a Unicode scalar value, as
+// UTF-8). Other backslashes are kept as written.
+inline std::string_view decodeString(std::string_view str, std::string& out) {
+  auto escape = str.find('\\');
+  if (escape == std::string_view::npos) {
+    return str;
+  }
 
-  // Numbers
-  Expr(int number): type(ExprType::NUMBER), number(number) {}
+  auto hexDigit = [](char c) {
+    return c >= '0' && c <= '9' ? c - '0'
+         : c >= 'a' && c <= 'f' ? c - 'a' + 10
+         : c >= 'A' && c <= 'F' ? c - 'A' + 10
+         : -1;
+  };
 
-  // Strings
-  Expr(std::string &strVal) {
-    if (strVal[0] == '"') {
-      type = ExprType::STRING;
-      string = strVal.substr(1, strVal.size() - 2);
-    } else {
-      type = ExprType::SYMBOL;
-      string = strVal;
+  out.assign(str.data(), escape);
+
+  for (auto i = escape; i < str.size(); i++) {
+    auto c = str[i];
+
+    if (c != '\\' || i + 1 == str.size()) {
+      out += c;
+      continue;
+    }
+
+    switch (auto e = str[++i]) {
+      case 'n': out += '\n'; break;
+      case 't': out += '\t'; break;
+      case 'r': out += '\r'; break;
+      case '0': out += '\0'; break;
+      case '\\': out += '\\'; break;
+      case '"': out += '"'; break;
+
+      case 'x':
+        if (i + 2 < str.size() && hexDigit(str[i + 1]) >= 0 && hexDigit(str[i + 2]) >= 0) {
+          out += (char)(hexDigit(str[i + 1]) * 16 + hexDigit(str[i + 2]));
+          i += 2;
+        } else {
+          out += "\\x";
+        }
+        break;
+
+      case 'u': {
+        // 1-6 hex digits in braces.
+        auto close = str.find('}', i + 1);
+        auto valid = close != std::string_view::npos && str[i + 1] == '{' && close > i + 2 && close <= i + 8;
+        uint32_t code = 0;
+
+        for (auto j = i + 2; valid && j < close; j++) {
+          valid = hexDigit(str[j]) >= 0;
+          code = code * 16 + hexDigit(str[j]);
+        }
+
+        // Up to U+10FFFF, without the surrogates (not valid in UTF-8).
+        if (!valid || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+          out += "\\u";
+          break;
+        }
+        i = close;
+
+        if (code < 0x80) {
+          out += (char)code;
+        } else if (code < 0x800) {
+          out += (char)(0xC0 | code >> 6);
+          out += (char)(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+          out += (char)(0xE0 | code >> 12);
+          out += (char)(0x80 | (code >> 6 & 0x3F));
+          out += (char)(0x80 | (code & 0x3F));
+        } else {
+          out += (char)(0xF0 | code >> 18);
+          out += (char)(0x80 | (code >> 12 & 0x3F));
+          out += (char)(0x80 | (code >> 6 & 0x3F));
+          out += (char)(0x80 | (code & 0x3F));
+        }
+        break;
+      }
+
+      default:
+        out += '\\';
+        out += e;
     }
   }
 
-  // Lists
-  Expr(std::vector<Expr> list): type(ExprType::LIST), list(list) {}
+  return out;
+}
 
-};
+// Decodes the contents of a STRING token, which the AST copies into its
+// arena. The result is valid until the next call on the same thread.
+inline std::string_view parseString(std::string_view str) {
+  thread_local std::string decoded;
+  return decodeString(str.substr(1, str.size() - 2), decoded);
+}
 
-using Value = Expr;  // clang-format on
+// Values are AST node IDs (or, for ListEntries, the start of the
+// pending list entries).
+using Value = NodeId;  // clang-format on
 
 namespace syntax {
 
@@ -125,21 +205,29 @@ enum class TokenType {
 // ------------------------------------------------------------------
 // Token.
 
+/**
+ * A token is a small value pointing into the tokenizing string; the
+ * matched text is available through `Tokenizer::tokenValue`, and its
+ * line/column through `Tokenizer::locationOf`.
+ */
 struct Token {
   TokenType type;
-  std::string value;
-
-  int startOffset;
-  int endOffset;
-  int startLine;
-  int endLine;
-  int startColumn;
-  int endColumn;
+
+  uint32_t offset;
+  uint32_t length;
 };
 
-using SharedToken = std::shared_ptr<Token>;
+static_assert(std::is_trivially_copyable_v<Token>);
 
-typedef TokenType (*LexRuleHandler)(const Tokenizer&, const std::string&);
+typedef TokenType (*LexRuleHandler)(const Tokenizer&, std::string_view);
+
+// ------------------------------------------------------------------
+// Source location: 1-based line, 0-based column.
+
+struct SourceLocation {
+  uint32_t line;
+  uint32_t column;
+};
 
 // ------------------------------------------------------------------
 // Lex rule: [regex, handler]
@@ -166,30 +254,26 @@ class Tokenizer {
   /**
    * Initializes a parsing string.
    */
-  void initString(const std::string& str) {
-    str_ = str;
+  void initString(std::string str) {
+    str_ = std::move(str);
 
     // Initialize states.
     states_.clear();
     states_.push_back(TokenizerState::INITIAL);
 
     cursor_ = 0;
-    currentLine_ = 1;
-    currentColumn_ = 0;
-    currentLineBeginOffset_ = 0;
+
+    // Built on demand by `locationOf`.
+    lineStartOffsets_.clear();
 
     tokenStartOffset_ = 0;
     tokenEndOffset_ = 0;
-    tokenStartLine_ = 0;
-    tokenEndLine_ = 0;
-    tokenStartColumn_ = 0;
-    tokenEndColumn_ = 0;
   }
 
   /**
    * Whether there are still tokens in the stream.
    */
-  inline bool hasMoreTokens() { return cursor_ <= str_.length(); }
+  inline bool hasMoreTokens() { return cursor_ <= (int)str_.length(); }
 
   /**
    * Returns current tokenizing state.
@@ -215,71 +299,148 @@ class Tokenizer {
     return state;
   }
 
+#ifdef EVA_USE_REGEX_LEXER
   /**
    * Returns next token.
    */
-  SharedToken getNextToken() {
-    if (!hasMoreTokens()) {
-      yytext = __EOF;
-      return toToken(TokenType::__EOF);
-    }
+  Token getNextToken() {
+    // Skipped matches (whitespace, comments) loop instead of recursing.
+    for (;;) {
+      if (!hasMoreTokens()) {
+        yytext = __EOF;
+        return toToken(TokenType::__EOF);
+      }
 
-    auto strSlice = str_.substr(cursor_);
+      // Match in place at the cursor, without copying the rest of the input.
+      auto strSlice = str_.cbegin() + cursor_;
 
-    auto lexRulesForState = lexRulesByStartConditions_.at(getCurrentState());
+      const auto& lexRulesForState =
+          lexRulesByStartConditions_.at(getCurrentState());
 
-    for (const auto& ruleIndex : lexRulesForState) {
-      auto rule = lexRules_[ruleIndex];
-      std::smatch sm;
+      auto tokenType = TokenType::__EOF;
 
-      if (std::regex_search(strSlice, sm, rule.regex)) {
-        yytext = sm[0];
+      for (const auto& ruleIndex : lexRulesForState) {
+        const auto& rule = lexRules_[ruleIndex];
+        std::smatch sm;
 
-        captureLocations_(yytext);
-        cursor_ += yytext.length();
+        if (std::regex_search(strSlice, str_.cend(), sm, rule.regex,
+                              std::regex_constants::match_continuous)) {
+          yytext = std::string_view(str_).substr(cursor_, sm.length(0));
 
-        // Manual handling of EOF token (the end of string). Return it
-        // as `EOF` symbol.
-        if (yytext.length() == 0) {
-          cursor_++;
-        }
+          captureLocations_(yytext);
+          cursor_ += yytext.length();
 
-        auto tokenType = rule.handler(*this, yytext);
+          // Manual handling of EOF token (the end of string). Return it
+          // as `EOF` symbol.
+          if (yytext.length() == 0) {
+            cursor_++;
+          }
 
-        if (tokenType == TokenType::__EMPTY) {
-          return getNextToken();
+          tokenType = rule.handler(*this, yytext);
+          break;
         }
+      }
 
+      if (tokenType == TokenType::__EMPTY) {
+        continue;
+      }
+
+      if (tokenType != TokenType::__EOF) {
         return toToken(tokenType);
       }
+
+      if (isEOF()) {
+        captureLocations_({});
+        cursor_++;
+        yytext = __EOF;
+        return toToken(TokenType::__EOF);
+      }
+
+      auto location = locationOf(cursor_);
+      throwUnexpectedToken(std::string(1, *strSlice), location.line,
+                           location.column);
     }
+  }
+#else
+  /**
+   * Returns next token.
+   *
+   * Hand-written DFA scanner for the Eva token set. Produces the same
+   * tokens and locations as the regex rules (see `EvaGrammar.bnf`), which
+   * can still be selected at build time with `EVA_USE_REGEX_LEXER`.
+   */
+  Token getNextToken() {
+    if (!hasMoreTokens()) {
+      yytext = __EOF;
+      return toToken(TokenType::__EOF);
+    }
+
+    cursor_ = skipTrivia_(cursor_);
 
     if (isEOF()) {
+      captureLocations_({});
       cursor_++;
       yytext = __EOF;
       return toToken(TokenType::__EOF);
     }
 
-    throwUnexpectedToken(std::string(1, strSlice[0]), currentLine_,
-                         currentColumn_);
+    auto tokenType = TokenType::__EMPTY;
+    auto end = scan_(cursor_, tokenType);
+
+    if (end < 0) {
+      auto location = locationOf(cursor_);
+      throwUnexpectedToken(std::string(1, str_[cursor_]), location.line,
+                           location.column);
+    }
+
+    yytext = std::string_view(str_).substr(cursor_, end - cursor_);
+
+    captureLocations_(yytext);
+    cursor_ = end;
+
+    return toToken(tokenType);
   }
+#endif
 
   /**
    * Whether the cursor is at the EOF.
    */
-  inline bool isEOF() { return cursor_ == str_.length(); }
+  inline bool isEOF() { return cursor_ == (int)str_.length(); }
 
-  SharedToken toToken(TokenType tokenType) {
-    return std::shared_ptr<Token>(new Token{
+  Token toToken(TokenType tokenType) {
+    return Token{
         .type = tokenType,
-        .value = yytext,
-        .startOffset = tokenStartOffset_,
-        .endOffset = tokenEndOffset_,
-        .startLine = tokenStartLine_,
-        .endLine = tokenEndLine_,
-        .startColumn = tokenStartColumn_,
-        .endColumn = tokenEndColumn_,
-    });
+        .offset = (uint32_t)tokenStartOffset_,
+        .length = (uint32_t)yytext.length(),
+    };
+  }
+
+  /**
+   * Returns the matched text of a token (a view into the tokenizing
+   * string).
+   */
+  std::string_view tokenValue(const Token& token) const {
+    if (token.type == TokenType::__EOF) {
+      return __EOF;
+    }
+    return std::string_view(str_).substr(token.offset, token.length);
+  }
+
+  /**
+   * Returns the line and column of an offset in the tokenizing string.
+   * Locations are only computed for diagnostics, by binary search over
+   * the line starts.
+   */
+  SourceLocation locationOf(uint32_t offset) {
+    const auto& lineStarts = lineStarts_();
+
+    auto line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) -
+                lineStarts.begin();
+
+    return SourceLocation{
+        .line = (uint32_t)line,
+        .column = offset - lineStarts[line - 1],
+    };
   }
 
   /**
@@ -289,12 +450,31 @@ class Tokenizer {
    */
   [[noreturn]] void throwUnexpectedToken(const std::string& symbol, int line,
                                          int column) {
-    std::stringstream ss{str_};
-    std::string lineStr;
-    int currentLine = 1;
+    throwSyntaxError("Unexpected token \"" + symbol + "\"", line, column);
+  }
 
-    while (currentLine++ <= line) {
-      std::getline(ss, lineStr, '\n');
+  /**
+   * Throws a syntax error at a token, given by its matched text.
+   */
+  [[noreturn]] void throwSyntaxError(const std::string& message,
+                                     std::string_view text) {
+    auto location = locationOf(text.data() - str_.data());
+    throwSyntaxError(message, location.line, location.column);
+  }
+
+  /**
+   * Throws a syntax error, showing the actual line from the source,
+   * pointing with the ^ marker to the `line:column` location.
+   */
+  [[noreturn]] void throwSyntaxError(const std::string& message, int line,
+                                     int column) {
+    std::string_view lineStr = str_;
+
+    if (line >= 1 && line <= (int)lineStarts_().size()) {
+      lineStr = lineStr.substr(lineStarts_()[line - 1]);
+      lineStr = lineStr.substr(0, lineStr.find('\n'));
+    } else {
+      lineStr = {};
     }
 
     auto pad = std::string(column, ' ');
@@ -303,58 +483,185 @@ class Tokenizer {
 
     errMsg << "Syntax Error:\n\n"
            << lineStr << "\n"
-           << pad << "^\nUnexpected token \"" << symbol << "\" at " << line
-           << ":" << column << "\n\n";
+           << pad << "^\n" << message << " at " << line << ":" << column
+           << "\n\n";
 
-    std::cerr << errMsg.str();
+    if (printErrors) {
+      std::cerr << errMsg.str();
+    }
     throw new std::runtime_error(errMsg.str().c_str());
   }
 
   /**
    * Matched text.
    */
-  std::string yytext;
+  std::string_view yytext;
 
- private:
   /**
-   * Captures token locations.
+   * Whether syntax errors are printed to stderr before being thrown.
    */
-  void captureLocations_(const std::string& matched) {
-    auto len = matched.length();
+  bool printErrors = true;
 
-    // Absolute offsets.
+  /**
+   * Character classes of NUMBER (\d) and SYMBOL ([\w\-+*=!<>/]) tokens.
+   */
+  static bool isDigit(char c) { return charClasses_[(unsigned char)c] & CC_DIGIT; }
+  static bool isSymbolChar(char c) { return charClasses_[(unsigned char)c] & CC_SYMBOL; }
+
+  /**
+   * Returns the offset of the quote closing a STRING token whose contents
+   * start at `pos`, skipping escaped characters, or npos.
+   */
+  static size_t findStringEnd(std::string_view str, size_t pos) {
+    while ((pos = str.find_first_of("\"\\", pos)) != std::string_view::npos && str[pos] == '\\') {
+      pos += 2;
+    }
+    return pos;
+  }
+
+ private:
+  /**
+   * Captures token locations (offsets only, see `locationOf`).
+   */
+  void captureLocations_(std::string_view matched) {
     tokenStartOffset_ = cursor_;
+    tokenEndOffset_ = cursor_ + matched.length();
+  }
+
+  /**
+   * Returns the offsets at which each line starts, scanning the string
+   * for newlines once on first use (memchr is vectorized by libc).
+   */
+  const std::vector<uint32_t>& lineStarts_() {
+    if (lineStartOffsets_.empty()) {
+      lineStartOffsets_.push_back(0);
+
+      const char* begin = str_.data();
+      auto end = begin + str_.length();
+
+      for (auto p = begin;
+           (p = (const char*)std::memchr(p, '\n', end - p)) != nullptr;) {
+        p++;
+        lineStartOffsets_.push_back(p - begin);
+      }
+    }
+    return lineStartOffsets_;
+  }
+
+  /**
+   * Character classes of the DFA scanner.
+   */
+  enum CharClass : uint8_t {
+    CC_DIGIT = 1 << 0,   // \d
+    CC_SYMBOL = 1 << 1,  // [\w\-+*=!<>/]
+  };
+
+  static constexpr std::array<uint8_t, 256> charClasses_ = [] {
+    std::array<uint8_t, 256> table{};
+
+    for (auto c = '0'; c <= '9'; c++) {
+      table[(unsigned char)c] |= CC_DIGIT | CC_SYMBOL;
+    }
+    for (auto c = 'a'; c <= 'z'; c++) {
+      table[(unsigned char)c] |= CC_SYMBOL;
+      table[(unsigned char)(c - 'a' + 'A')] |= CC_SYMBOL;
+    }
+    for (auto c : {'_', '-', '+', '*', '=', '!', '<', '>', '/'}) {
+      table[(unsigned char)c] |= CC_SYMBOL;
+    }
+
+    return table;
+  }();
+
+#ifndef EVA_USE_REGEX_LEXER
+  /**
+   * Skips whitespace and comments at `pos` (lex rules 3-5) in a single
+   * loop, using the SIMD helpers. Returns the offset of the next token.
+   */
+  int skipTrivia_(size_t pos) const {
+    auto s = str_.data();
+    auto length = str_.length();
+
+    for (;;) {
+      pos = scan::skipSpaces(s, pos, length);
+
+      if (pos + 1 >= length || s[pos] != '/') {
+        return pos;
+      }
+
+      // Line comment: `.` stops at both line terminators.
+      if (s[pos + 1] == '/') {
+        pos = scan::findLineEnd(s, pos + 2, length);
+        continue;
+      }
+
+      // Block comment; an unterminated one is lexed as a symbol.
+      if (s[pos + 1] == '*') {
+        auto close = scan::findBlockCommentEnd(s, pos + 2, length);
+        if (close < length) {
+          pos = close + 2;
+          continue;
+        }
+      }
+
+      return pos;
+    }
+  }
+
+  /**
+   * Matches a token at `pos` (after `skipTrivia_`), following the
+   * priority of the lex rules. Sets the token type and returns the end
+   * offset of the match, or -1 if no rule matches.
+   */
+  int scan_(int pos, TokenType& tokenType) const {
+    auto length = (int)str_.length();
+    auto end = pos + 1;
+
+    switch (str_[pos]) {
+      case '(':
+        tokenType = TokenType::TOKEN_TYPE_7;
+        return end;
+
+      case ')':
+        tokenType = TokenType::TOKEN_TYPE_8;
+        return end;
+
+      case '"': {
+        auto close = findStringEnd(str_, end);
+        if (close == std::string::npos) {
+          return -1;
+        }
+        tokenType = TokenType::STRING;
+        return close + 1;
+      }
+    }
 
-    // Line-based locations, start.
-    tokenStartLine_ = currentLine_;
-    tokenStartColumn_ = tokenStartOffset_ - currentLineBeginOffset_;
-
-    // Extract `\n` in the matched token.
-    std::stringstream ss{matched};
-    std::string lineStr;
-    std::getline(ss, lineStr, '\n');
-    while (ss.tellg() > 0 && ss.tellg() <= len) {
-      currentLine_++;
-      currentLineBeginOffset_ = tokenStartOffset_ + ss.tellg();
-      std::getline(ss, lineStr, '\n');
+    if (isDigit(str_[pos])) {
+      while (end < length && isDigit(str_[end])) end++;
+      tokenType = TokenType::NUMBER;
+      return end;
     }
 
-    tokenEndOffset_ = cursor_ + len;
+    if (isSymbolChar(str_[pos])) {
+      while (end < length && isSymbolChar(str_[end])) end++;
+      tokenType = TokenType::SYMBOL;
+      return end;
+    }
 
-    // Line-based locations, end.
-    tokenEndLine_ = currentLine_;
-    tokenEndColumn_ = tokenEndOffset_ - currentLineBeginOffset_;
-    currentColumn_ = tokenEndColumn_;
+    return -1;
   }
+#endif
 
   /**
    * Lexical rules.
    */
+#ifdef EVA_USE_REGEX_LEXER
   // clang-format off
   static constexpr size_t LEX_RULES_COUNT = 8;
   static std::array<LexRule, LEX_RULES_COUNT> lexRules_;
   static std::map<TokenizerState, std::vector<size_t>> lexRulesByStartConditions_;
   // clang-format on
+#endif
 
   /**
    * Special EOF token.
@@ -377,21 +684,15 @@ class Tokenizer {
   std::vector<TokenizerState> states_;
 
   /**
-   * Line-based location tracking.
+   * Offsets of line starts, for line-based locations.
    */
-  int currentLine_;
-  int currentColumn_;
-  int currentLineBeginOffset_;
+  std::vector<uint32_t> lineStartOffsets_;
 
   /**
    * Location data of a matched token.
    */
   int tokenStartOffset_;
   int tokenEndOffset_;
-  int tokenStartLine_;
-  int tokenEndLine_;
-  int tokenStartColumn_;
-  int tokenEndColumn_;
 };
 
 // ------------------------------------------------------------------
@@ -400,39 +701,40 @@ class Tokenizer {
 std::string Tokenizer::__EOF("$");
 
 // clang-format off
-inline TokenType _lexRule1(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule1(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::TOKEN_TYPE_7;
 }
 
-inline TokenType _lexRule2(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule2(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::TOKEN_TYPE_8;
 }
 
-inline TokenType _lexRule3(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule3(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::__EMPTY;
 }
 
-inline TokenType _lexRule4(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule4(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::__EMPTY;
 }
 
-inline TokenType _lexRule5(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule5(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::__EMPTY;
 }
 
-inline TokenType _lexRule6(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule6(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::STRING;
 }
 
-inline TokenType _lexRule7(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule7(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::NUMBER;
 }
 
-inline TokenType _lexRule8(const Tokenizer& tokenizer, const std::string& yytext) {
+inline TokenType _lexRule8(const Tokenizer& tokenizer, std::string_view yytext) {
 return TokenType::SYMBOL;
 }
 // clang-format on
 
+#ifdef EVA_USE_REGEX_LEXER
 // ------------------------------------------------------------------
 // Lexical rules.
 
@@ -443,25 +745,26 @@ std::array<LexRule, Tokenizer::LEX_RULES_COUNT> Tokenizer::lexRules_ = {{
   {std::regex(R"(^\/\/.*)"), &_lexRule3},
   {std::regex(R"(^\/\*[\s\S]*?\*\/)"), &_lexRule4},
   {std::regex(R"(^\s+)"), &_lexRule5},
-  {std::regex(R"(^"[^\"]*")"), &_lexRule6},
+  {std::regex(R"(^"(\\[\s\S]|[^"\\])*")"), &_lexRule6},
   {std::regex(R"(^\d+)"), &_lexRule7},
   {std::regex(R"(^[\w\-+*=!<>/]+)"), &_lexRule8}
 }};
 std::map<TokenizerState, std::vector<size_t>> Tokenizer::lexRulesByStartConditions_ =  {{TokenizerState::INITIAL, {0, 1, 2, 3, 4, 5, 6, 7}}};
 // clang-format on
+#endif
 
 #endif
 // clang-format on
 
-#define POP_V()              \
-  parser.valuesStack.back(); \
+#define POP_V()                         \
+  std::move(parser.valuesStack.back()); \
   parser.valuesStack.pop_back()
 
 #define POP_T()              \
   parser.tokensStack.back(); \
   parser.tokensStack.pop_back()
 
-#define PUSH_VR() parser.valuesStack.push_back(__)
+#define PUSH_VR() parser.valuesStack.push_back(std::move(__))
 #define PUSH_TR() parser.tokensStack.push_back(__)
 
 /**
@@ -482,6 +785,20 @@ struct TableEntry {
   int value;
 };
 
+/**
+ * Packed parsing table entry: the `TE` type + 1 in the low 3 bits and
+ * the value above them; 0 is an empty (error) entry.
+ */
+using PackedEntry = uint16_t;
+
+constexpr PackedEntry packEntry(TE type, int value) {
+  return (PackedEntry)((value << 3) | ((int)type + 1));
+}
+
+constexpr TableEntry unpackEntry(PackedEntry entry) {
+  return TableEntry{.type = (TE)((entry & 7) - 1), .value = entry >> 3};
+}
+
 // clang-format off
 class EvaParser;
 // clang-format on
@@ -502,9 +819,10 @@ struct Production {
   ProductionHandler handler;
 };
 
-// Key: Encoded symbol (terminal or non-terminal) index
-// Value: TableEntry
-using Row = std::map<int, TableEntry>;
+// Columns: encoded symbol (terminal or non-terminal) index.
+static constexpr size_t COLUMNS_COUNT = 10;
+
+using Row = std::array<PackedEntry, COLUMNS_COUNT>;
 
 /**
  * Parser class.
@@ -521,7 +839,7 @@ class EvaParser {
   /**
    * Token values stack.
    */
-  std::vector<std::string> tokensStack;
+  std::vector<std::string_view> tokensStack;
 
   /**
    * Parsing states stack.
@@ -533,6 +851,19 @@ class EvaParser {
    */
   Tokenizer tokenizer;
 
+  /**
+   * AST arena built by the semantic actions.
+   */
+  Ast ast;
+
+  /**
+   * Streaming mode: if set, each entry of the outermost list is passed to
+   * this callback (as a view rooted at the entry) as soon as it is
+   * reduced, and its nodes are freed after it returns. The outermost list
+   * itself is left empty.
+   */
+  std::function<void(AstView form)> onTopLevelForm;
+
   /**
    * Previous state to calculate the next one.
    */
@@ -541,13 +872,13 @@ class EvaParser {
   /**
    * Parses a string.
    */
-  Value parse(const std::string& str) {
+  Value parse(std::string str) {
     // clang-format off
-    
+    ast.clear();
     // clang-format on
 
     // Initialize the tokenizer and the string.
-    tokenizer.initString(str);
+    tokenizer.initString(std::move(str));
 
     // Initialize the stacks.
     valuesStack.clear();
@@ -563,18 +894,20 @@ class EvaParser {
     // Main parsing loop.
     for (;;) {
       auto state = statesStack.back();
-      auto column = (int)token->type;
+      auto column = (int)token.type;
 
-      if (table_[state].count(column) == 0) {
+      auto packedEntry = table_[state][column];
+
+      if (packedEntry == 0) {
         throwUnexpectedToken(token);
       }
 
-      auto entry = table_[state].at(column);
+      auto entry = unpackEntry(packedEntry);
 
       // Shift a token, go to state.
       if (entry.type == TE::Shift) {
         // Push token.
-        tokensStack.push_back(token->value);
+        tokensStack.push_back(tokenizer.tokenValue(token));
 
         // Push next state number: "s5" -> 5
         statesStack.push_back(entry.value);
@@ -588,7 +921,7 @@ class EvaParser {
         auto productionNumber = entry.value;
         auto production = productions_[productionNumber];
 
-        tokenizer.yytext = shiftedToken->value;
+        tokenizer.yytext = tokenizer.tokenValue(shiftedToken);
 
         auto rhsLength = production.rhsLength;
         while (rhsLength > 0) {
@@ -602,7 +935,7 @@ class EvaParser {
         auto previousState = statesStack.back();
 
         auto symbolToReduceWith = production.opcode;
-        auto nextStateEntry = table_[previousState].at(symbolToReduceWith);
+        auto nextStateEntry = unpackEntry(table_[previousState][symbolToReduceWith]);
         assert(nextStateEntry.type == TE::Transit);
 
         statesStack.push_back(nextStateEntry.value);
@@ -615,7 +948,7 @@ class EvaParser {
 
         // Pop the parsed value.
         // clang-format off
-        auto result = valuesStack.back(); valuesStack.pop_back();
+        auto result = std::move(valuesStack.back()); valuesStack.pop_back();
         // clang-format on
 
         if (statesStack.size() != 1 || statesStack.back() != 0 ||
@@ -626,7 +959,7 @@ class EvaParser {
         statesStack.pop_back();
 
         // clang-format off
-        
+        ast.setRoot(result);
         // clang-format on
 
         return result;
@@ -634,18 +967,49 @@ class EvaParser {
     }
   }
 
+  /**
+   * Adds an entry to the innermost list being parsed, or streams it if it
+   * is a top-level form.
+   */
+  void addListEntry(NodeId entry) {
+    if (onTopLevelForm && ast.openLists() == 1) {
+      onTopLevelForm(ast.view(entry));
+
+      // Only this form is in the arena: earlier ones were freed already.
+      ast.clearNodes();
+      return;
+    }
+
+    ast.addListEntry(entry);
+  }
+
+  /**
+   * Adds a number to the AST, throwing a syntax error if its NUMBER token
+   * is out of range.
+   */
+  NodeId addNumber(std::string_view token) {
+    int number;
+    if (!parseNumber(token, number)) {
+      tokenizer.throwSyntaxError("Number \"" + std::string(token) + "\" is out of range", token);
+    }
+    return ast.addNumber(number);
+  }
+
  private:
   /**
    * Throws parser error on unexpected token.
    */
-  [[noreturn]] void throwUnexpectedToken(SharedToken token) {
-    if (token->type == TokenType::__EOF && !tokenizer.hasMoreTokens()) {
+  [[noreturn]] void throwUnexpectedToken(const Token& token) {
+    if (token.type == TokenType::__EOF && !tokenizer.hasMoreTokens()) {
       std::string errMsg = "Unexpected end of input.\n";
-      std::cerr << errMsg;
+      if (tokenizer.printErrors) {
+        std::cerr << errMsg;
+      }
       throw std::runtime_error(errMsg.c_str());
     }
-    tokenizer.throwUnexpectedToken(token->value, token->startLine,
-                                   token->startColumn);
+    auto location = tokenizer.locationOf(token.offset);
+    tokenizer.throwUnexpectedToken(std::string(tokenizer.tokenValue(token)),
+                                   location.line, location.column);
   }
 
   // clang-format off
@@ -653,7 +1017,21 @@ class EvaParser {
   static std::array<Production, PRODUCTIONS_COUNT> productions_;
 
   static constexpr size_t ROWS_COUNT = 11;
-  static std::array<Row, ROWS_COUNT> table_;
+
+  // Dense action/goto table: one indexed load per parser step.
+  static constexpr std::array<Row, ROWS_COUNT> table_ = {{
+    {{ packEntry(TE::Transit, 1),  packEntry(TE::Transit, 2),  packEntry(TE::Transit, 3),                          0,    packEntry(TE::Shift, 4),    packEntry(TE::Shift, 5),    packEntry(TE::Shift, 6),    packEntry(TE::Shift, 7),                          0,                          0}},
+    {{                         0,                          0,                          0,                          0,                          0,                          0,                          0,                          0,                          0,   packEntry(TE::Accept, 0)}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 1),   packEntry(TE::Reduce, 1),   packEntry(TE::Reduce, 1),   packEntry(TE::Reduce, 1),   packEntry(TE::Reduce, 1),   packEntry(TE::Reduce, 1)}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 2),   packEntry(TE::Reduce, 2),   packEntry(TE::Reduce, 2),   packEntry(TE::Reduce, 2),   packEntry(TE::Reduce, 2),   packEntry(TE::Reduce, 2)}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 3),   packEntry(TE::Reduce, 3),   packEntry(TE::Reduce, 3),   packEntry(TE::Reduce, 3),   packEntry(TE::Reduce, 3),   packEntry(TE::Reduce, 3)}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 4),   packEntry(TE::Reduce, 4),   packEntry(TE::Reduce, 4),   packEntry(TE::Reduce, 4),   packEntry(TE::Reduce, 4),   packEntry(TE::Reduce, 4)}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 5),   packEntry(TE::Reduce, 5),   packEntry(TE::Reduce, 5),   packEntry(TE::Reduce, 5),   packEntry(TE::Reduce, 5),   packEntry(TE::Reduce, 5)}},
+    {{                         0,                          0,                          0,  packEntry(TE::Transit, 8),   packEntry(TE::Reduce, 7),   packEntry(TE::Reduce, 7),   packEntry(TE::Reduce, 7),   packEntry(TE::Reduce, 7),   packEntry(TE::Reduce, 7),                          0}},
+    {{packEntry(TE::Transit, 10),  packEntry(TE::Transit, 2),  packEntry(TE::Transit, 3),                          0,    packEntry(TE::Shift, 4),    packEntry(TE::Shift, 5),    packEntry(TE::Shift, 6),    packEntry(TE::Shift, 7),    packEntry(TE::Shift, 9),                          0}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 6),   packEntry(TE::Reduce, 6),   packEntry(TE::Reduce, 6),   packEntry(TE::Reduce, 6),   packEntry(TE::Reduce, 6),   packEntry(TE::Reduce, 6)}},
+    {{                         0,                          0,                          0,                          0,   packEntry(TE::Reduce, 8),   packEntry(TE::Reduce, 8),   packEntry(TE::Reduce, 8),   packEntry(TE::Reduce, 8),   packEntry(TE::Reduce, 8),                          0}},
+  }};
   // clang-format on
 };
 
@@ -665,7 +1043,7 @@ void _handler1(yyparse& parser) {
 // Semantic action prologue.
 auto _1 = POP_V();
 
-auto __ = _1;
+auto __ = std::move(_1);
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -676,7 +1054,7 @@ void _handler2(yyparse& parser) {
 // Semantic action prologue.
 auto _1 = POP_V();
 
-auto __ = _1;
+auto __ = std::move(_1);
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -687,7 +1065,7 @@ void _handler3(yyparse& parser) {
 // Semantic action prologue.
 auto _1 = POP_V();
 
-auto __ = _1;
+auto __ = std::move(_1);
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -698,7 +1076,7 @@ void _handler4(yyparse& parser) {
 // Semantic action prologue.
 auto _1 = POP_T();
 
-auto __ = Expr(std::stoi(_1)) ;
+auto __ = parser.addNumber(_1) ;
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -709,7 +1087,7 @@ void _handler5(yyparse& parser) {
 // Semantic action prologue.
 auto _1 = POP_T();
 
-auto __ = Expr(_1) ;
+auto __ = parser.ast.addString(parseString(_1)) ;
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -720,7 +1098,7 @@ void _handler6(yyparse& parser) {
 // Semantic action prologue.
 auto _1 = POP_T();
 
-auto __ = Expr(_1) ;
+auto __ = parser.ast.addSymbol(intern(_1)) ;
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -733,7 +1111,7 @@ parser.tokensStack.pop_back();
 auto _2 = POP_V();
 parser.tokensStack.pop_back();
 
-auto __ = _2 ;
+auto __ = parser.ast.addList(_2) ;
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -744,7 +1122,7 @@ void _handler8(yyparse& parser) {
 // Semantic action prologue.
 
 
-auto __ = Expr(std::vector<Expr> {}) ;
+auto __ = parser.ast.beginList() ;
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -756,7 +1134,7 @@ void _handler9(yyparse& parser) {
 auto _2 = POP_V();
 auto _1 = POP_V();
 
-_1.list.push_back(_2); auto __ = _1 ;
+parser.addListEntry(_2); auto __ = _1 ;
 
  // Semantic action epilogue.
 PUSH_VR();
@@ -776,25 +1154,6 @@ std::array<Production, yyparse::PRODUCTIONS_COUNT> yyparse::productions_ = {{{-1
 {3, 2, &_handler9}}};
 // clang-format on
 
-// ------------------------------------------------------------------
-// Parsing table.
-
-// clang-format off
-std::array<Row, yyparse::ROWS_COUNT> yyparse::table_ = {
-    Row {{0, {TE::Transit, 1}}, {1, {TE::Transit, 2}}, {2, {TE::Transit, 3}}, {4, {TE::Shift, 4}}, {5, {TE::Shift, 5}}, {6, {TE::Shift, 6}}, {7, {TE::Shift, 7}}},
-    Row {{9, {TE::Accept, 0}}},
-    Row {{4, {TE::Reduce, 1}}, {5, {TE::Reduce, 1}}, {6, {TE::Reduce, 1}}, {7, {TE::Reduce, 1}}, {8, {TE::Reduce, 1}}, {9, {TE::Reduce, 1}}},
-    Row {{4, {TE::Reduce, 2}}, {5, {TE::Reduce, 2}}, {6, {TE::Reduce, 2}}, {7, {TE::Reduce, 2}}, {8, {TE::Reduce, 2}}, {9, {TE::Reduce, 2}}},
-    Row {{4, {TE::Reduce, 3}}, {5, {TE::Reduce, 3}}, {6, {TE::Reduce, 3}}, {7, {TE::Reduce, 3}}, {8, {TE::Reduce, 3}}, {9, {TE::Reduce, 3}}},
-    Row {{4, {TE::Reduce, 4}}, {5, {TE::Reduce, 4}}, {6, {TE::Reduce, 4}}, {7, {TE::Reduce, 4}}, {8, {TE::Reduce, 4}}, {9, {TE::Reduce, 4}}},
-    Row {{4, {TE::Reduce, 5}}, {5, {TE::Reduce, 5}}, {6, {TE::Reduce, 5}}, {7, {TE::Reduce, 5}}, {8, {TE::Reduce, 5}}, {9, {TE::Reduce, 5}}},
-    Row {{3, {TE::Transit, 8}}, {4, {TE::Reduce, 7}}, {5, {TE::Reduce, 7}}, {6, {TE::Reduce, 7}}, {7, {TE::Reduce, 7}}, {8, {TE::Reduce, 7}}},
-    Row {{0, {TE::Transit, 10}}, {1, {TE::Transit, 2}}, {2, {TE::Transit, 3}}, {4, {TE::Shift, 4}}, {5, {TE::Shift, 5}}, {6, {TE::Shift, 6}}, {7, {TE::Shift, 7}}, {8, {TE::Shift, 9}}},
-    Row {{4, {TE::Reduce, 6}}, {5, {TE::Reduce, 6}}, {6, {TE::Reduce, 6}}, {7, {TE::Reduce, 6}}, {8, {TE::Reduce, 6}}, {9, {TE::Reduce, 6}}},
-    Row {{4, {TE::Reduce, 8}}, {5, {TE::Reduce, 8}}, {6, {TE::Reduce, 8}}, {7, {TE::Reduce, 8}}, {8, {TE::Reduce, 8}}}
-};
-// clang-format on
-
 }  // namespace syntax
 
 #endif
\ No newline at end of file
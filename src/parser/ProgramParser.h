@@ -0,0 +1,211 @@
+/*
+ * Program parser: parses top-level forms in parallel.
+ */
+
+#ifndef EVA_PROGRAMPARSER_H
+#define EVA_PROGRAMPARSER_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "EvaParser.h"
+#include "SimdScan.h"
+
+namespace syntax {
+
+/*
+ * Parses a whole program into the implicit `(begin <forms>)`.
+ *
+ * Large programs are split at top-level form boundaries (respecting
+ * strings and comments) into chunks, which are tokenized and parsed on
+ * worker threads and stitched back in source order. Small or malformed
+ * programs are parsed sequentially, so syntax errors are reported with
+ * their locations in the whole program.
+ */
+class ProgramParser {
+ public:
+
+  ProgramParser(unsigned threads = std::thread::hardware_concurrency())
+      : threads_(std::max(threads, 1u)) {}
+
+  /*
+   * Parses a program as `(begin <forms>)`.
+   */
+  Ast parse(const std::string& program) {
+    std::vector<size_t> formEnds;
+
+    if (threads_ == 1 || program.size() < MIN_PARALLEL_SIZE ||
+        !findFormEnds_(program, formEnds)) {
+      return parseSequential_(program);
+    }
+
+    auto chunks = split_(program, formEnds);
+
+    // Each chunk is parsed as a list of its forms, in its own arena.
+    std::vector<Ast> results(chunks.size());
+    std::atomic<size_t> nextChunk = 0;
+    std::atomic<bool> failed = false;
+
+    auto worker = [&]() {
+      EvaParser parser;
+      parser.tokenizer.printErrors = false;
+
+      for (auto i = nextChunk++; i < chunks.size() && !failed; i = nextChunk++) {
+        try {
+          parser.parse("(" + std::string(chunks[i]) + ")");
+          results[i] = std::move(parser.ast);
+        } catch (...) {
+          failed = true;
+        }
+      }
+    };
+
+    std::vector<std::thread> workers;
+    auto workersCount = std::min<size_t>(threads_, chunks.size());
+
+    for (size_t i = 0; i < workersCount; i++) {
+      workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+      thread.join();
+    }
+
+    // Re-parse sequentially to report the error in the whole program.
+    if (failed) {
+      return parseSequential_(program);
+    }
+
+    // Stitch the chunks into one arena, in source order.
+    Ast ast;
+    std::vector<NodeId> forms {ast.addSymbol(SYM_BEGIN)};
+
+    for (const auto& chunk : results) {
+      auto base = ast.append(chunk);
+
+      for (auto form : chunk.children(chunk.root())) {
+        forms.push_back(base + form);
+      }
+    }
+
+    ast.setRoot(ast.addList(forms));
+    return ast;
+  }
+
+  /*
+   * Parses a program form by form, passing each top-level form to the
+   * callback as soon as it is parsed. Only the form being passed is kept
+   * in memory, so there is no parallel parsing and no whole-program AST.
+   */
+  void parseForms(const std::string& program, std::function<void(AstView form)> onForm) {
+    EvaParser parser;
+    parser.onTopLevelForm = std::move(onForm);
+
+    parser.parse("(" + program + ")");
+  }
+
+ private:
+
+  /*
+   * Parses a program on the calling thread.
+   */
+  Ast parseSequential_(const std::string& program) {
+    parser_.parse("(begin " + program + ")");
+    return std::move(parser_.ast);
+  }
+
+  /*
+   * Programs smaller than this are parsed on the calling thread.
+   */
+  static constexpr size_t MIN_PARALLEL_SIZE = 256 * 1024;
+
+  /*
+   * Chunks per worker thread, for load balancing.
+   */
+  static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+  /*
+   * Collects the offsets right after each top-level list. Returns false
+   * if the parens are unbalanced or a string is unterminated.
+   */
+  static bool findFormEnds_(std::string_view program, std::vector<size_t>& formEnds) {
+    auto s = program.data();
+    auto length = program.size();
+    auto depth = 0;
+
+    // Follows the tokenizer's rules, so `//` inside a symbol is not a
+    // comment, and `/*` without a closing `*/` is a symbol.
+    for (size_t pos = 0, close; pos < length;) {
+      auto c = s[pos];
+
+      if (c == '(') {
+        depth++;
+        pos++;
+      } else if (c == ')') {
+        if (--depth < 0) {
+          return false;
+        }
+        pos++;
+        if (depth == 0) {
+          formEnds.push_back(pos);
+        }
+      } else if (c == '"') {
+        close = Tokenizer::findStringEnd(program, pos + 1);
+        if (close == std::string_view::npos) {
+          return false;
+        }
+        pos = close + 1;
+      } else if (c == '/' && pos + 1 < length && s[pos + 1] == '/') {
+        pos = scan::findLineEnd(s, pos + 2, length);
+      } else if (c == '/' && pos + 1 < length && s[pos + 1] == '*' &&
+                 (close = scan::findBlockCommentEnd(s, pos + 2, length)) < length) {
+        pos = close + 2;
+      } else if (Tokenizer::isDigit(c)) {
+        while (pos < length && Tokenizer::isDigit(s[pos])) pos++;
+      } else if (Tokenizer::isSymbolChar(c)) {
+        while (pos < length && Tokenizer::isSymbolChar(s[pos])) pos++;
+      } else {
+        pos++;
+      }
+    }
+
+    return depth == 0;
+  }
+
+  /*
+   * Splits the program at form ends into chunks of similar size.
+   */
+  std::vector<std::string_view> split_(std::string_view program,
+                                       const std::vector<size_t>& formEnds) {
+    std::vector<std::string_view> chunks;
+
+    auto chunkSize = program.size() / (threads_ * CHUNKS_PER_THREAD) + 1;
+    size_t chunkStart = 0;
+
+    for (auto end : formEnds) {
+      if (end - chunkStart >= chunkSize) {
+        chunks.push_back(program.substr(chunkStart, end - chunkStart));
+        chunkStart = end;
+      }
+    }
+
+    // The rest, including trailing atoms and comments.
+    chunks.push_back(program.substr(chunkStart));
+
+    return chunks;
+  }
+
+  // Worker threads count.
+  unsigned threads_;
+
+  // Parser for sequential parsing.
+  EvaParser parser_;
+};
+
+}  // namespace syntax
+
+#endif //EVA_PROGRAMPARSER_H
@@ -0,0 +1,155 @@
+/*
+ * SIMD scanning helpers for the tokenizer: skipping whitespace and
+ * finding comment ends 32 (AVX2) or 16 (SSE2) bytes at a time, with a
+ * scalar fallback. Define EVA_NO_SIMD to force the scalar path.
+ */
+
+#ifndef EVA_SIMD_SCAN_H
+#define EVA_SIMD_SCAN_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(EVA_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define EVA_SIMD_AVX2
+#elif !defined(EVA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define EVA_SIMD_SSE2
+#endif
+
+namespace syntax::scan {
+
+#if defined(EVA_SIMD_AVX2)
+
+/*
+ * 32-byte vector operations.
+ */
+struct Vec {
+  using Type = __m256i;
+  static constexpr size_t width = 32;
+
+  static Type load(const char* p) { return _mm256_loadu_si256((const __m256i*)p); }
+  static Type splat(char c) { return _mm256_set1_epi8(c); }
+  static Type eq(Type a, Type b) { return _mm256_cmpeq_epi8(a, b); }
+  static Type sub(Type a, Type b) { return _mm256_sub_epi8(a, b); }
+  static Type minU(Type a, Type b) { return _mm256_min_epu8(a, b); }
+  static Type or_(Type a, Type b) { return _mm256_or_si256(a, b); }
+  static Type and_(Type a, Type b) { return _mm256_and_si256(a, b); }
+  static uint32_t mask(Type a) { return (uint32_t)_mm256_movemask_epi8(a); }
+};
+
+#elif defined(EVA_SIMD_SSE2)
+
+/*
+ * 16-byte vector operations.
+ */
+struct Vec {
+  using Type = __m128i;
+  static constexpr size_t width = 16;
+
+  static Type load(const char* p) { return _mm_loadu_si128((const __m128i*)p); }
+  static Type splat(char c) { return _mm_set1_epi8(c); }
+  static Type eq(Type a, Type b) { return _mm_cmpeq_epi8(a, b); }
+  static Type sub(Type a, Type b) { return _mm_sub_epi8(a, b); }
+  static Type minU(Type a, Type b) { return _mm_min_epu8(a, b); }
+  static Type or_(Type a, Type b) { return _mm_or_si128(a, b); }
+  static Type and_(Type a, Type b) { return _mm_and_si128(a, b); }
+  static uint32_t mask(Type a) { return (uint32_t)_mm_movemask_epi8(a) & 0xFFFF; }
+};
+
+#endif
+
+/*
+ * Whitespace as matched by `\s`: ' ', \t, \n, \v, \f, \r.
+ */
+inline bool isSpace(char c) {
+  return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+/*
+ * Returns the offset of the first non-whitespace byte at or after `pos`.
+ */
+inline size_t skipSpaces(const char* s, size_t pos, size_t length) {
+#if defined(EVA_SIMD_AVX2) || defined(EVA_SIMD_SSE2)
+  const auto space = Vec::splat(' ');
+  const auto tab = Vec::splat('\t');
+  const auto range = Vec::splat('\r' - '\t');
+
+  for (; pos + Vec::width <= length; pos += Vec::width) {
+    auto v = Vec::load(s + pos);
+
+    // \t..\r as an unsigned range check: min(v - '\t', 4) == v - '\t'.
+    auto d = Vec::sub(v, tab);
+    auto spaces = Vec::or_(Vec::eq(v, space), Vec::eq(Vec::minU(d, range), d));
+
+    auto other = ~Vec::mask(spaces) & (~0u >> (32 - Vec::width));
+    if (other != 0) {
+      return pos + std::countr_zero(other);
+    }
+  }
+#endif
+
+  while (pos < length && isSpace(s[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+/*
+ * Returns the offset of the first line terminator (\n or \r) at or after
+ * `pos`, or `length` if there is none.
+ */
+inline size_t findLineEnd(const char* s, size_t pos, size_t length) {
+#if defined(EVA_SIMD_AVX2) || defined(EVA_SIMD_SSE2)
+  const auto lf = Vec::splat('\n');
+  const auto cr = Vec::splat('\r');
+
+  for (; pos + Vec::width <= length; pos += Vec::width) {
+    auto v = Vec::load(s + pos);
+    auto found = Vec::mask(Vec::or_(Vec::eq(v, lf), Vec::eq(v, cr)));
+
+    if (found != 0) {
+      return pos + std::countr_zero(found);
+    }
+  }
+#endif
+
+  while (pos < length && s[pos] != '\n' && s[pos] != '\r') {
+    pos++;
+  }
+  return pos;
+}
+
+/*
+ * Returns the offset of the first "*\/" at or after `pos`, or `length`
+ * if there is none.
+ */
+inline size_t findBlockCommentEnd(const char* s, size_t pos, size_t length) {
+#if defined(EVA_SIMD_AVX2) || defined(EVA_SIMD_SSE2)
+  const auto star = Vec::splat('*');
+  const auto slash = Vec::splat('/');
+
+  // Compares each byte with '*' and the byte after it with '/'.
+  for (; pos + Vec::width + 1 <= length; pos += Vec::width) {
+    auto found = Vec::mask(Vec::and_(Vec::eq(Vec::load(s + pos), star),
+                                     Vec::eq(Vec::load(s + pos + 1), slash)));
+
+    if (found != 0) {
+      return pos + std::countr_zero(found);
+    }
+  }
+#endif
+
+  for (; pos + 1 < length; pos++) {
+    if (s[pos] == '*' && s[pos + 1] == '/') {
+      return pos;
+    }
+  }
+  return length;
+}
+
+}  // namespace syntax::scan
+
+#endif //EVA_SIMD_SCAN_H
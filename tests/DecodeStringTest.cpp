@@ -0,0 +1,103 @@
+/*
+ * String escapes test.
+ *
+ * Checks the decoding of each escape sequence of string literals, that
+ * malformed escapes are kept as written, and that the parser stores the
+ * decoded contents of STRING tokens, including embedded NULs.
+ *
+ * Usage: eva_decode_string_test
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/parser/ProgramParser.h"
+#include "Test.h"
+
+using namespace std::string_view_literals;
+
+static std::string decode(std::string_view contents) {
+  std::string out;
+  return std::string(decodeString(contents, out));
+}
+
+/*
+ * Contents of the STRING nodes of a program, in node order.
+ */
+static std::vector<std::string> stringsOf(const std::string& program, unsigned threads) {
+  syntax::ProgramParser parser(threads);
+  auto ast = parser.parse(program);
+
+  std::vector<std::string> strings;
+  for (const auto& node : ast.view().nodes()) {
+    if (node.type == ExprType::STRING) {
+      strings.emplace_back(ast.string(node));
+    }
+  }
+  return strings;
+}
+
+int main() {
+  // No escapes.
+  CHECK(decode("") == "");
+  CHECK(decode("plain text") == "plain text");
+
+  // Each escape.
+  CHECK(decode(R"(\n)") == "\n");
+  CHECK(decode(R"(\t)") == "\t");
+  CHECK(decode(R"(\r)") == "\r");
+  CHECK(decode(R"(\0)") == "\0"sv);
+  CHECK(decode(R"(\\)") == "\\");
+  CHECK(decode(R"(\")") == "\"");
+  CHECK(decode(R"(\x41\x7a\xFF)") == "Az\xFF");
+  CHECK(decode(R"(\u{41})") == "A");
+  CHECK(decode(R"(\u{e9})") == "\xC3\xA9");
+  CHECK(decode(R"(\u{20AC})") == "\xE2\x82\xAC");
+  CHECK(decode(R"(\u{1F600})") == "\xF0\x9F\x98\x80");
+  CHECK(decode(R"(\u{10FFFF})") == "\xF4\x8F\xBF\xBF");
+  CHECK(decode(R"(a\nb\tc)") == "a\nb\tc");
+
+  // Malformed \x: kept as written.
+  CHECK(decode(R"(\x)") == R"(\x)");
+  CHECK(decode(R"(\x4)") == R"(\x4)");
+  CHECK(decode(R"(\x4g)") == R"(\x4g)");
+  CHECK(decode(R"(\xg1)") == R"(\xg1)");
+
+  // Malformed \u: kept as written.
+  CHECK(decode(R"(\u41)") == R"(\u41)");
+  CHECK(decode(R"(\u{)") == R"(\u{)");
+  CHECK(decode(R"(\u{41)") == R"(\u{41)");
+  CHECK(decode(R"(\u{})") == R"(\u{})");
+  CHECK(decode(R"(\u{4g})") == R"(\u{4g})");
+  CHECK(decode(R"(\u{1234567})") == R"(\u{1234567})");
+  CHECK(decode(R"(\u{110000})") == R"(\u{110000})");
+  CHECK(decode(R"(\u{D800})") == R"(\u{D800})");
+  CHECK(decode(R"(\u{DFFF})") == R"(\u{DFFF})");
+
+  // Unknown escapes and a trailing backslash: kept as written.
+  CHECK(decode(R"(\q)") == R"(\q)");
+  CHECK(decode(R"(a\)") == R"(a\)");
+
+  // Parsed literals: small programs are parsed on the calling thread,
+  // large ones on worker threads.
+  auto forms = std::string(R"EVA((printf "a\0b\n") (printf "\"(\")" 1) (printf "end\\"))EVA");
+
+  for (auto copies : {1, 20000}) {
+    std::string program;
+    for (auto i = 0; i < copies; i++) {
+      program += forms;
+    }
+
+    auto strings = stringsOf(program, 4);
+    CHECK(strings.size() == 3u * copies);
+
+    for (size_t i = 0; i + 2 < strings.size(); i += 3) {
+      CHECK(strings[i] == "a\0b\n"sv);
+      CHECK(strings[i + 1] == "\"(\")");
+      CHECK(strings[i + 2] == "end\\");
+    }
+  }
+
+  return testResult();
+}
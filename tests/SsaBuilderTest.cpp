@@ -0,0 +1,140 @@
+/*
+ * SsaBuilder test.
+ *
+ * Builds a diamond and a loop with the SsaBuilder, sealing the blocks as
+ * codegen does, and checks where phis are placed: one at the join of the
+ * diamond for the variable assigned in one branch, ones at the loop
+ * header for the variables updated in the body, and none for a variable
+ * that is not assigned in the loop.
+ *
+ * Usage: eva_ssa_test
+ */
+
+#include <iterator>
+#include <string_view>
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "../src/SsaBuilder.h"
+#include "Test.h"
+
+static size_t phisCount(llvm::BasicBlock* block) {
+  return std::distance(block->phis().begin(), block->phis().end());
+}
+
+static llvm::PHINode* phiOf(llvm::BasicBlock* block, std::string_view name) {
+  for (auto& phi : block->phis()) {
+    if (std::string_view(phi.getName()).starts_with(name)) {
+      return &phi;
+    }
+  }
+  return nullptr;
+}
+
+int main() {
+  llvm::LLVMContext ctx;
+  llvm::Module module("SsaBuilderTest", ctx);
+  llvm::IRBuilder<> builder(ctx);
+
+  auto i32 = builder.getInt32Ty();
+  auto fn = llvm::Function::Create(llvm::FunctionType::get(i32, {i32}, false),
+                                   llvm::Function::ExternalLinkage, "f", module);
+  auto n = fn->getArg(0);
+
+  SsaBuilder ssa;
+  auto x = ssa.addVariable(intern("x"), i32);
+  auto y = ssa.addVariable(intern("y"), i32);
+  auto z = ssa.addVariable(intern("z"), i32);
+
+  // x = 0; y = n; z = 7
+  auto entry = llvm::BasicBlock::Create(ctx, "entry", fn);
+  ssa.sealBlock(entry);
+  builder.SetInsertPoint(entry);
+
+  ssa.write(x, entry, builder.getInt32(0));
+  ssa.write(y, entry, n);
+  ssa.write(z, entry, builder.getInt32(7));
+
+  // Diamond: if (n > 0) x = 1
+  auto thenBlock = llvm::BasicBlock::Create(ctx, "then", fn);
+  auto elseBlock = llvm::BasicBlock::Create(ctx, "else", fn);
+  auto join = llvm::BasicBlock::Create(ctx, "join", fn);
+
+  builder.CreateCondBr(builder.CreateICmpSGT(n, builder.getInt32(0)), thenBlock, elseBlock);
+  ssa.sealBlock(thenBlock);
+  ssa.sealBlock(elseBlock);
+
+  builder.SetInsertPoint(thenBlock);
+  ssa.write(x, thenBlock, builder.getInt32(1));
+  builder.CreateBr(join);
+
+  builder.SetInsertPoint(elseBlock);
+  builder.CreateBr(join);
+
+  ssa.sealBlock(join);
+  builder.SetInsertPoint(join);
+
+  // Loop: while (y > 0) { x = x + y + z; y = y - 1 }, with the header
+  // sealed only once the back edge exists.
+  auto header = llvm::BasicBlock::Create(ctx, "header", fn);
+  auto body = llvm::BasicBlock::Create(ctx, "body", fn);
+  auto exit = llvm::BasicBlock::Create(ctx, "exit", fn);
+
+  builder.CreateBr(header);
+  builder.SetInsertPoint(header);
+  builder.CreateCondBr(builder.CreateICmpSGT(ssa.read(y, header), builder.getInt32(0)), body, exit);
+
+  ssa.sealBlock(body);
+  builder.SetInsertPoint(body);
+
+  auto sum = builder.CreateAdd(builder.CreateAdd(ssa.read(x, body), ssa.read(y, body)), ssa.read(z, body));
+  ssa.write(x, body, sum);
+  ssa.write(y, body, builder.CreateSub(ssa.read(y, body), builder.getInt32(1)));
+  builder.CreateBr(header);
+
+  ssa.sealBlock(header);
+  ssa.sealBlock(exit);
+
+  builder.SetInsertPoint(exit);
+  auto xAtExit = ssa.read(x, exit);
+  auto zAtExit = ssa.read(z, exit);
+  builder.CreateRet(builder.CreateAdd(xAtExit, zAtExit));
+
+  CHECK(!llvm::verifyFunction(*fn, &llvm::errs()));
+
+  // Join: only x differs between the branches.
+  CHECK(phisCount(join) == 1);
+  auto xAtJoin = phiOf(join, "x");
+  CHECK(xAtJoin != nullptr);
+  if (xAtJoin) {
+    CHECK(xAtJoin->getIncomingValueForBlock(thenBlock) == builder.getInt32(1));
+    CHECK(xAtJoin->getIncomingValueForBlock(elseBlock) == builder.getInt32(0));
+  }
+
+  // Header: x and y are updated in the body, z is not.
+  CHECK(phisCount(header) == 2);
+  auto xAtHeader = phiOf(header, "x");
+  auto yAtHeader = phiOf(header, "y");
+  CHECK(xAtHeader != nullptr);
+  CHECK(yAtHeader != nullptr);
+  CHECK(phiOf(header, "z") == nullptr);
+  if (xAtHeader && yAtHeader) {
+    CHECK(xAtHeader->getIncomingValueForBlock(join) == xAtJoin);
+    CHECK(xAtHeader->getIncomingValueForBlock(body) == sum);
+    CHECK(yAtHeader->getIncomingValueForBlock(join) == n);
+  }
+
+  // No other phis: the exit reads the header's x, and z is the constant.
+  CHECK(phisCount(body) == 0);
+  CHECK(phisCount(exit) == 0);
+  CHECK(xAtExit == xAtHeader);
+  CHECK(zAtExit == builder.getInt32(7));
+
+  if (failedChecks() > 0) {
+    fn->print(llvm::errs());
+  }
+  return testResult();
+}
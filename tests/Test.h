@@ -0,0 +1,42 @@
+/*
+ * Test helpers.
+ */
+
+#ifndef EVA_TEST_H
+#define EVA_TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+
+/*
+ * Number of failed checks.
+ */
+inline int& failedChecks() {
+  static int failed = 0;
+  return failed;
+}
+
+/*
+ * Checks a condition, reporting its location if it does not hold.
+ */
+#define CHECK(condition)                                                      \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,  \
+                   #condition);                                               \
+      failedChecks()++;                                                       \
+    }                                                                         \
+  } while (false)
+
+/*
+ * Exit code of a test: failure if any check failed.
+ */
+inline int testResult() {
+  if (failedChecks() > 0) {
+    std::fprintf(stderr, "%d check(s) failed.\n", failedChecks());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+#endif //EVA_TEST_H